@@ -0,0 +1,45 @@
+#ifndef __AVL_ALGORITHMS_HPP__
+#define __AVL_ALGORITHMS_HPP__
+
+/// Structural AVL operations shared by the tree variants whose nodes are not
+/// plain MultiSet nodes (file offsets, pool indices, intrusive hooks).
+///
+/// NodeTraits is an object, so it may carry state such as a base address,
+/// and it has to provide:
+///     typedef ... node_ptr;
+///     node_ptr null() const;
+///     node_ptr parent(node_ptr n) const;   void setParent(node_ptr n, node_ptr p);
+///     node_ptr left(node_ptr n) const;     void setLeft(node_ptr n, node_ptr l);
+///     node_ptr right(node_ptr n) const;    void setRight(node_ptr n, node_ptr r);
+///     int balance(node_ptr n) const;       void setBalance(node_ptr n, int b);
+/// where balance is height(right) - height(left), always -1, 0 or 1.
+/// None of the operations allocate or compare keys.
+template <typename NodeTraits>
+class AvlAlgorithms
+{
+public:
+    typedef typename NodeTraits::node_ptr node_ptr;
+
+    static node_ptr leftMost(const NodeTraits& t, node_ptr n);
+    static node_ptr rightMost(const NodeTraits& t, node_ptr n);
+    static node_ptr next(const NodeTraits& t, node_ptr n);
+    static node_ptr prev(const NodeTraits& t, node_ptr n);
+    static int height(const NodeTraits& t, node_ptr root);
+
+    /// Links the detached node n below parent (as the root if parent is null)
+    /// and restores the AVL invariant.
+    static void insert(const NodeTraits& t, node_ptr& root, node_ptr parent, bool isLeft, node_ptr n);
+    /// Unlinks n from the tree and restores the AVL invariant.
+    /// n itself is left untouched for the caller to release.
+    static void erase(const NodeTraits& t, node_ptr& root, node_ptr n);
+
+private:
+    static void replaceChild(const NodeTraits& t, node_ptr& root, node_ptr parent, node_ptr oldChild, node_ptr newChild);
+    static node_ptr rotateLeft(const NodeTraits& t, node_ptr& root, node_ptr n);
+    static node_ptr rotateRight(const NodeTraits& t, node_ptr& root, node_ptr n);
+    static node_ptr rebalance(const NodeTraits& t, node_ptr& root, node_ptr n, int factor, bool& heightDecreased);
+};
+
+#include "templates/AvlAlgorithms.cpp"
+#endif /// __AVL_ALGORITHMS_HPP__
+
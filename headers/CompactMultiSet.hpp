@@ -0,0 +1,123 @@
+#ifndef __COMPACT_MULTI_SET_HPP__
+#define __COMPACT_MULTI_SET_HPP__
+
+#include "headers/AvlAlgorithms.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+/// Sorted multiset whose AVL nodes live in one index-addressed pool.
+/// Links are 32-bit slot numbers (0 meaning none) instead of pointers and
+/// the balance factor is kept in the two top bits of the parent link, so a
+/// node is the key plus 12 bytes, with no per-node allocation header.
+/// For 4-byte keys that is 16 bytes per element against 32 bytes plus the
+/// malloc overhead of a MultiSet node. Holds up to MAX_SIZE elements.
+template <typename Data>
+class CompactMultiSet
+{
+private:
+    struct Node {
+        Data data_;
+        uint32_t parent_;
+        uint32_t left_;
+        uint32_t right_;
+    };
+
+    enum { BALANCE_SHIFT = 30 };
+    static const uint32_t LINK_MASK = (uint32_t(1) << BALANCE_SHIFT) - 1;
+
+    /// Balance b is stored as b + 1 in the bits above the parent slot.
+    struct NodeTraits {
+        typedef uint32_t node_ptr;
+        explicit NodeTraits(Node* nodes) : nodes_(nodes) {}
+        uint32_t null() const { return 0; }
+        uint32_t parent(uint32_t n) const { return nodes_[n].parent_ & LINK_MASK; }
+        uint32_t left(uint32_t n) const { return nodes_[n].left_; }
+        uint32_t right(uint32_t n) const { return nodes_[n].right_; }
+        int balance(uint32_t n) const { return int(nodes_[n].parent_ >> BALANCE_SHIFT) - 1; }
+        void setParent(uint32_t n, uint32_t p) const { nodes_[n].parent_ = (nodes_[n].parent_ & ~LINK_MASK) | p; }
+        void setLeft(uint32_t n, uint32_t l) const { nodes_[n].left_ = l; }
+        void setRight(uint32_t n, uint32_t r) const { nodes_[n].right_ = r; }
+        void setBalance(uint32_t n, int b) const
+        {
+            nodes_[n].parent_ = (nodes_[n].parent_ & LINK_MASK) | (uint32_t(b + 1) << BALANCE_SHIFT);
+        }
+        Node* nodes_;
+    };
+    typedef AvlAlgorithms<NodeTraits> Algorithms;
+
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+
+    static const size_type MAX_SIZE = LINK_MASK - 1;
+
+    class const_iterator {
+        friend class CompactMultiSet<Data>;
+    public:
+        const_iterator();
+        const value_type& operator*() const;
+        const value_type* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator& rhv) const;
+        bool operator!=(const const_iterator& rhv) const;
+    private:
+        const_iterator(const CompactMultiSet* set, uint32_t index);
+    private:
+        const CompactMultiSet* set_;
+        uint32_t index_;
+    };
+    typedef const_iterator iterator;
+
+public:
+    CompactMultiSet();
+    template <typename InputIterator>
+    CompactMultiSet(InputIterator first, InputIterator last);
+    void swap(CompactMultiSet& rhv);
+
+    size_type size() const;
+    bool empty() const;
+    size_type max_size() const;
+    size_type capacity() const;
+    void reserve(size_type count);
+    void clear();
+    int height() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const_iterator insert(const value_type& x);
+    void erase(const_iterator pos);
+    size_type erase(const key_type& k);
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+    static size_type node_size();
+
+private:
+    NodeTraits traits() const;
+    uint32_t allocateNode(const value_type& x);
+    void freeNode(uint32_t n);
+
+private:
+    /// Slot 0 is the null link and never holds an element.
+    std::vector<Node> nodes_;
+    uint32_t root_;
+    uint32_t freeList_;
+    size_type size_;
+};
+
+#include "templates/CompactMultiSet.cpp"
+#endif /// __COMPACT_MULTI_SET_HPP__
+
@@ -0,0 +1,75 @@
+#ifndef __FROZEN_BLOCK_MULTI_SET_HPP__
+#define __FROZEN_BLOCK_MULTI_SET_HPP__
+
+#include "headers/SimdSearch.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// Immutable sorted multiset of arithmetic keys laid out as a static B+ tree.
+/// The keys are kept sorted in one array (the leaves), cut into blocks of
+/// one cache line, and every internal node is one cache line of separator
+/// keys with BLOCK + 1 children. Each level is resolved by one SimdSearch
+/// kernel call (compare against the whole block, count the mask bits), so
+/// a lookup touches one cache line per level and has no key-dependent
+/// branches. Iterators are plain pointers into the sorted array.
+template <typename Data>
+class FrozenBlockMultiSet
+{
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+
+    enum { BLOCK = SimdSearch<Data>::BLOCK };
+
+public:
+    FrozenBlockMultiSet();
+    template <typename InputIt>
+    FrozenBlockMultiSet(InputIt sortedFirst, size_type count);
+    void swap(FrozenBlockMultiSet& rhv);
+
+    size_type size() const;
+    bool empty() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+    /// Positions (ranks) of lower_bound for every key; a few searches are
+    /// run side by side so that their cache misses overlap.
+    void lower_bound_batch(const key_type* keys, size_type count, size_type* positions) const;
+    void count_batch(const key_type* keys, size_type count, size_type* counts) const;
+
+    static const char* instruction_set();
+
+private:
+    void build();
+    size_type search(const key_type& k, typename SimdSearch<Data>::Kernel kernel) const;
+    void searchBatch(const key_type* keys, size_type count, size_type* positions,
+                     typename SimdSearch<Data>::Kernel kernel) const;
+    static Data padding();
+
+private:
+    std::vector<Data> leaves_;
+    std::vector<Data> nodes_;
+    /// Per level, bottom up (level 0 are the leaf blocks): first node in
+    /// nodes_ and number of blocks.
+    std::vector<size_type> levelOffset_;
+    std::vector<size_type> levelBlocks_;
+    size_type size_;
+    typename SimdSearch<Data>::Kernels kernels_;
+};
+
+#include "templates/FrozenBlockMultiSet.cpp"
+#endif /// __FROZEN_BLOCK_MULTI_SET_HPP__
+
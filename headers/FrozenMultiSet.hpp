@@ -0,0 +1,82 @@
+#ifndef __FROZEN_MULTI_SET_HPP__
+#define __FROZEN_MULTI_SET_HPP__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// Immutable sorted multiset stored in one array in Eytzinger (BFS) order:
+/// the children of slot k are 2k and 2k + 1, slot 0 is unused. A descent
+/// touches consecutive levels of the implicit tree, which sit next to each
+/// other in memory, so the search runs without branches on the key and can
+/// prefetch the cache line of the node four levels further down.
+/// Built by MultiSet::freeze() or from any sorted input range.
+template <typename Data>
+class FrozenMultiSet
+{
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+
+    class const_iterator {
+        friend class FrozenMultiSet<Data>;
+    public:
+        const_iterator();
+        const value_type& operator*() const;
+        const value_type* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator& rhv) const;
+        bool operator!=(const const_iterator& rhv) const;
+    private:
+        const_iterator(const FrozenMultiSet* set, size_type index);
+    private:
+        const FrozenMultiSet* set_;
+        size_type index_;
+    };
+    typedef const_iterator iterator;
+
+public:
+    FrozenMultiSet();
+    template <typename InputIt>
+    FrozenMultiSet(InputIt sortedFirst, size_type count);
+    void swap(FrozenMultiSet& rhv);
+
+    size_type size() const;
+    bool empty() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+private:
+    template <typename InputIt>
+    void fillHelper(size_type index, InputIt& sortedFirst);
+    size_type lowerIndex(const key_type& k) const;
+    size_type upperIndex(const key_type& k) const;
+    size_type rank(const key_type& k, bool isUpper) const;
+    size_type leftSubtreeSize(size_type index, int depth) const;
+    void prefetch(size_type index) const;
+    static size_type resolve(size_type index);
+    size_type next(size_type index) const;
+    size_type prev(size_type index) const;
+
+private:
+    std::vector<Data> keys_;
+    size_type size_;
+    int levels_;
+};
+
+#include "templates/FrozenMultiSet.cpp"
+#endif /// __FROZEN_MULTI_SET_HPP__
+
@@ -0,0 +1,119 @@
+#ifndef __INTRUSIVE_MULTI_SET_HPP__
+#define __INTRUSIVE_MULTI_SET_HPP__
+
+#include "headers/AvlAlgorithms.hpp"
+#include <cstddef>
+#include <utility>
+
+/// Links and balance of one object in one IntrusiveMultiSet. An object can
+/// sit in several sets at once by embedding one hook per set. Copying an
+/// object does not copy its links: the copy starts out unlinked.
+class MultiSetHook
+{
+    template <typename D, MultiSetHook D::*H> friend class IntrusiveMultiSet;
+public:
+    MultiSetHook() : parent_(NULL), left_(NULL), right_(NULL), balance_(0), isLinked_(false) {}
+    MultiSetHook(const MultiSetHook&) : parent_(NULL), left_(NULL), right_(NULL), balance_(0), isLinked_(false) {}
+    MultiSetHook& operator=(const MultiSetHook&) { return *this; }
+    bool is_linked() const { return isLinked_; }
+private:
+    MultiSetHook* parent_;
+    MultiSetHook* left_;
+    MultiSetHook* right_;
+    signed char balance_;
+    bool isLinked_;
+};
+
+/// Sorted multiset of objects owned by the caller. insert links the object
+/// through its Hook member, so nothing is allocated or copied, and unlink
+/// takes it out in O(log n) given just a reference to the object; erase of
+/// a key removes every equal object. Objects
+/// must outlive their membership and must not change their key while linked.
+template <typename Data, MultiSetHook Data::*Hook>
+class IntrusiveMultiSet
+{
+private:
+    struct NodeTraits {
+        typedef MultiSetHook* node_ptr;
+        MultiSetHook* null() const { return NULL; }
+        MultiSetHook* parent(MultiSetHook* n) const { return n->parent_; }
+        MultiSetHook* left(MultiSetHook* n) const { return n->left_; }
+        MultiSetHook* right(MultiSetHook* n) const { return n->right_; }
+        int balance(MultiSetHook* n) const { return n->balance_; }
+        void setParent(MultiSetHook* n, MultiSetHook* p) const { n->parent_ = p; }
+        void setLeft(MultiSetHook* n, MultiSetHook* l) const { n->left_ = l; }
+        void setRight(MultiSetHook* n, MultiSetHook* r) const { n->right_ = r; }
+        void setBalance(MultiSetHook* n, int b) const { n->balance_ = static_cast<signed char>(b); }
+    };
+    typedef AvlAlgorithms<NodeTraits> Algorithms;
+
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+
+    class iterator {
+        friend class IntrusiveMultiSet<Data, Hook>;
+    public:
+        iterator();
+        value_type& operator*() const;
+        value_type* operator->() const;
+        iterator& operator++();
+        iterator operator++(int);
+        iterator& operator--();
+        iterator operator--(int);
+        bool operator==(const iterator& rhv) const;
+        bool operator!=(const iterator& rhv) const;
+    private:
+        iterator(const IntrusiveMultiSet* set, MultiSetHook* hook);
+    private:
+        const IntrusiveMultiSet* set_;
+        MultiSetHook* hook_;
+    };
+    typedef iterator const_iterator;
+
+public:
+    IntrusiveMultiSet();
+    ~IntrusiveMultiSet();
+    void swap(IntrusiveMultiSet& rhv);
+
+    size_type size() const;
+    bool empty() const;
+    void clear();
+    int height() const;
+
+    iterator begin() const;
+    iterator end() const;
+    iterator iterator_to(value_type& x) const;
+
+    iterator insert(value_type& x);
+    void erase(iterator pos);
+    size_type erase(const key_type& k);
+    void unlink(value_type& x);
+
+    iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    iterator lower_bound(const key_type& k) const;
+    iterator upper_bound(const key_type& k) const;
+    std::pair<iterator, iterator> equal_range(const key_type& k) const;
+
+private:
+    IntrusiveMultiSet(const IntrusiveMultiSet&);
+    const IntrusiveMultiSet& operator=(const IntrusiveMultiSet&);
+
+    static MultiSetHook* toHook(value_type& x);
+    static value_type& toValue(MultiSetHook* hook);
+    static std::ptrdiff_t hookOffset();
+    static void unlinkHook(MultiSetHook* hook);
+
+private:
+    MultiSetHook* root_;
+    size_type size_;
+};
+
+#include "templates/IntrusiveMultiSet.cpp"
+#endif /// __INTRUSIVE_MULTI_SET_HPP__
+
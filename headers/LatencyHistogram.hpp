@@ -0,0 +1,47 @@
+#ifndef __LATENCY_HISTOGRAM_HPP__
+#define __LATENCY_HISTOGRAM_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+/// Log-linear histogram of latencies in nanoseconds, in the style of
+/// HdrHistogram: values below SUB_BUCKETS are counted exactly, larger ones
+/// in buckets whose width is a 1 / (SUB_BUCKETS / 2) fraction of their
+/// value, so a percentile is within 1% of the true one at any magnitude.
+/// Recording is a few shifts and an increment, cheap enough to time every
+/// single operation. min and max are kept exactly.
+class LatencyHistogram
+{
+public:
+    enum { SUB_BUCKET_BITS = 8, SUB_BUCKETS = 1 << SUB_BUCKET_BITS };
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    void merge(const LatencyHistogram& rhv);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const;
+    /// Smallest bucket bound at or below which percent of the values lie.
+    uint64_t percentile(double percent) const;
+
+private:
+    static std::size_t bucketOf(uint64_t value);
+    static uint64_t highestValueOf(std::size_t bucket);
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+};
+
+#include "templates/LatencyHistogram.cpp"
+#endif /// __LATENCY_HISTOGRAM_HPP__
+
@@ -0,0 +1,65 @@
+#ifndef __MULTI_SET_AUGMENT_HPP__
+#define __MULTI_SET_AUGMENT_HPP__
+
+#include <algorithm>
+#include <limits>
+
+/// Augment policies keep a monoid aggregate of every subtree in its root
+/// node, which lets MultiSet::range_aggregate combine a key range in
+/// O(log n). A policy provides
+///     enum { ENABLED = 1 };
+///     typedef ... value_type;
+///     static value_type identity();
+///     static value_type lift(const Data& x);
+///     static value_type combine(const value_type& lhv, const value_type& rhv);
+/// combine must be associative; it is always applied in key order, so it
+/// need not be commutative.
+
+/// Node storage for the aggregate; nothing at all without augmentation.
+template <typename Value>
+struct MultiSetAggregate {
+    Value aggregate_;
+};
+
+template <>
+struct MultiSetAggregate<void> {};
+
+/// Default policy: no aggregate, no extra work on updates.
+struct NoAugment
+{
+    enum { ENABLED = 0 };
+    typedef void value_type;
+};
+
+template <typename Data>
+struct SumAugment
+{
+    enum { ENABLED = 1 };
+    typedef Data value_type;
+    static value_type identity() { return value_type(); }
+    static value_type lift(const Data& x) { return x; }
+    static value_type combine(const value_type& lhv, const value_type& rhv) { return lhv + rhv; }
+};
+
+template <typename Data>
+struct MinAugment
+{
+    enum { ENABLED = 1 };
+    typedef Data value_type;
+    static value_type identity() { return std::numeric_limits<Data>::max(); }
+    static value_type lift(const Data& x) { return x; }
+    static value_type combine(const value_type& lhv, const value_type& rhv) { return std::min(lhv, rhv); }
+};
+
+template <typename Data>
+struct MaxAugment
+{
+    enum { ENABLED = 1 };
+    typedef Data value_type;
+    static value_type identity() { return std::numeric_limits<Data>::lowest(); }
+    static value_type lift(const Data& x) { return x; }
+    static value_type combine(const value_type& lhv, const value_type& rhv) { return std::max(lhv, rhv); }
+};
+
+#endif /// __MULTI_SET_AUGMENT_HPP__
+
@@ -0,0 +1,137 @@
+#ifndef __MULTI_SET_BALANCE_HPP__
+#define __MULTI_SET_BALANCE_HPP__
+
+#include <cstddef>
+#include <type_traits>
+
+/// Balance policies keep one Info value in every MultiSet node and restore
+/// their invariant after the set links a new leaf or unlinks a node.
+/// They restructure the tree only through Tree::rotateUp(n), which lifts n
+/// above its parent and refreshes the Info of both nodes through update().
+///
+///     typedef ... Info;
+///     static Info leafInfo();
+///     static void update(Node* n);      /// Info of n from its children
+///     static void afterInsert(Tree& tree, Node* n);
+///     static void afterErase(Tree& tree, Node* parent, Node* child, bool isLeft, Info removed);
+///     static void afterBuild(Node* n, int depth, int maxDepth);
+///     static long check(const Node* n); /// see below
+///
+/// afterErase gets the node that took the place of the unlinked one (child,
+/// may be NULL), its parent, the side it hangs on and the Info the unlinked
+/// position had. afterBuild is called bottom up on a tree built perfectly
+/// balanced, where every leaf is at depth maxDepth - 1 or maxDepth.
+/// check verifies the invariant on the subtree of n, the stored Info
+/// included, and returns -1 if it is broken; otherwise a non-negative
+/// value of the subtree for its parent's check (height, black height or
+/// size).
+/// Info must be an integer type whose top bit the policy never sets: the
+/// set keeps the lazy-erase mark of a node there (see MultiSetBalanceInfo).
+
+/// The Info of a node together with its lazy-erase mark in the top bit, so
+/// the mark costs no space. It reads and assigns as a plain Info, and
+/// assigning an Info, even another node's, leaves the mark of this node
+/// as it is; only a copy construction (node relocation) takes the mark over.
+template <typename Info>
+class MultiSetBalanceInfo
+{
+public:
+    explicit MultiSetBalanceInfo(Info info) : bits_(static_cast<Bits>(info)) {}
+    MultiSetBalanceInfo(const MultiSetBalanceInfo& rhv) : bits_(rhv.bits_) {}
+    MultiSetBalanceInfo& operator=(const MultiSetBalanceInfo& rhv) { return *this = static_cast<Info>(rhv); }
+    MultiSetBalanceInfo& operator=(Info info) { bits_ = (bits_ & DEAD) | static_cast<Bits>(info); return *this; }
+    operator Info() const { return static_cast<Info>(bits_ & ~DEAD); }
+
+    bool isDead() const { return 0 != (bits_ & DEAD); }
+    void setDead() { bits_ |= DEAD; }
+
+private:
+    typedef typename std::make_unsigned<Info>::type Bits;
+    static const Bits DEAD = static_cast<Bits>(~(static_cast<Bits>(~Bits(0)) >> 1));
+    Bits bits_;
+};
+
+/// Incremental AVL: Info is the subtree height. Retracing stops as soon as
+/// a subtree keeps its height, so an update costs O(1) amortized rotations
+/// and the tree stays the lowest of the three.
+class AvlBalance
+{
+public:
+    typedef signed char Info;
+
+    static Info leafInfo() { return 1; }
+    template <typename Node>
+    static void update(Node* n);
+    template <typename Tree, typename Node>
+    static void afterInsert(Tree& tree, Node* n);
+    template <typename Tree, typename Node>
+    static void afterErase(Tree& tree, Node* parent, Node* child, bool isLeft, Info removed);
+    template <typename Node>
+    static void afterBuild(Node* n, int depth, int maxDepth);
+    template <typename Node>
+    static long check(const Node* n);
+
+private:
+    template <typename Node>
+    static int height(const Node* n);
+    template <typename Tree, typename Node>
+    static Node* fix(Tree& tree, Node* n);
+};
+
+/// Red-black: Info is the color. At most two rotations per insert and three
+/// per erase, so it rotates least on write-heavy workloads at the price of
+/// a somewhat deeper tree.
+class RedBlackBalance
+{
+public:
+    typedef unsigned char Info;
+    enum { BLACK = 0, RED = 1 };
+
+    static Info leafInfo() { return RED; }
+    template <typename Node>
+    static void update(Node*) {}
+    template <typename Tree, typename Node>
+    static void afterInsert(Tree& tree, Node* n);
+    template <typename Tree, typename Node>
+    static void afterErase(Tree& tree, Node* parent, Node* child, bool isLeft, Info removed);
+    template <typename Node>
+    static void afterBuild(Node* n, int depth, int maxDepth);
+    template <typename Node>
+    static long check(const Node* n);
+
+private:
+    template <typename Node>
+    static bool isRed(const Node* n);
+};
+
+/// Weight-balanced (BB[alpha] with the Adams parameters delta = 3 and
+/// gamma = 2): Info is the subtree size. The sizes would also allow an
+/// O(log n) rank and split/join by weight, which the set does not offer.
+class WeightBalance
+{
+public:
+    typedef std::size_t Info;
+    enum { DELTA = 3, GAMMA = 2 };
+
+    static Info leafInfo() { return 1; }
+    template <typename Node>
+    static void update(Node* n);
+    template <typename Tree, typename Node>
+    static void afterInsert(Tree& tree, Node* n);
+    template <typename Tree, typename Node>
+    static void afterErase(Tree& tree, Node* parent, Node* child, bool isLeft, Info removed);
+    template <typename Node>
+    static void afterBuild(Node* n, int depth, int maxDepth);
+    template <typename Node>
+    static long check(const Node* n);
+
+private:
+    template <typename Node>
+    static std::size_t weight(const Node* n);
+    template <typename Tree, typename Node>
+    static Node* fix(Tree& tree, Node* n);
+};
+
+#include "templates/MultiSetBalance.cpp"
+#endif /// __MULTI_SET_BALANCE_HPP__
+
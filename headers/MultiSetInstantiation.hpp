@@ -0,0 +1,83 @@
+#ifndef __MULTI_SET_INSTANTIATION_HPP__
+#define __MULTI_SET_INSTANTIATION_HPP__
+
+#include "headers/Multiset.hpp"
+#include <string>
+
+#ifdef MULTISET_TRACK_MEMORY
+#error "libMultiSet is built without MULTISET_TRACK_MEMORY; use the headers alone to track memory"
+#endif /// MULTISET_TRACK_MEMORY
+
+/// The members of MultiSet<T> that libMultiSet compiles once, so that the
+/// translation units using them do not. PREFIX is "template" for the
+/// instantiations in the library and "extern template" for the
+/// declarations every user sees. range_aggregate needs an Augment policy
+/// and the member templates depend on their arguments; those stay
+/// implicitly instantiated where they are used.
+#define MULTISET_INSTANTIATE(PREFIX, T)                                                                   \
+    PREFIX class MultiSet<T>::const_iterator;                                                             \
+    PREFIX class MultiSet<T>::iterator;                                                                   \
+    PREFIX class MultiSet<T>::const_reverse_iterator;                                                     \
+    PREFIX class MultiSet<T>::reverse_iterator;                                                           \
+    PREFIX class MultiSet<T>::node_type;                                                                  \
+    PREFIX MultiSet<T>::MultiSet();                                                                       \
+    PREFIX MultiSet<T>::MultiSet(const MultiSet<T>&);                                                     \
+    PREFIX MultiSet<T>::~MultiSet();                                                                      \
+    PREFIX const MultiSet<T>& MultiSet<T>::operator=(const MultiSet<T>&);                                 \
+    PREFIX void MultiSet<T>::swap(MultiSet<T>&);                                                          \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::size() const;                                              \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::max_size() const;                                          \
+    PREFIX void MultiSet<T>::clear();                                                                     \
+    PREFIX bool MultiSet<T>::empty() const;                                                               \
+    PREFIX bool MultiSet<T>::operator==(const MultiSet<T>&) const;                                        \
+    PREFIX bool MultiSet<T>::operator!=(const MultiSet<T>&) const;                                        \
+    PREFIX bool MultiSet<T>::operator<(const MultiSet<T>&) const;                                         \
+    PREFIX bool MultiSet<T>::operator<=(const MultiSet<T>&) const;                                        \
+    PREFIX bool MultiSet<T>::operator>(const MultiSet<T>&) const;                                         \
+    PREFIX bool MultiSet<T>::operator>=(const MultiSet<T>&) const;                                        \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::begin();                                                    \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::end();                                                      \
+    PREFIX MultiSet<T>::const_iterator MultiSet<T>::begin() const;                                        \
+    PREFIX MultiSet<T>::const_iterator MultiSet<T>::end() const;                                          \
+    PREFIX MultiSet<T>::reverse_iterator MultiSet<T>::rbegin();                                           \
+    PREFIX MultiSet<T>::reverse_iterator MultiSet<T>::rend();                                             \
+    PREFIX MultiSet<T>::const_reverse_iterator MultiSet<T>::rbegin() const;                               \
+    PREFIX MultiSet<T>::const_reverse_iterator MultiSet<T>::rend() const;                                 \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::insert(const T&);                                           \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::insert(MultiSet<T>::iterator, const T&);                    \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::insert(MultiSet<T>::node_type&&);                           \
+    PREFIX void MultiSet<T>::erase(MultiSet<T>::iterator);                                                \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::erase(const T&);                                           \
+    PREFIX void MultiSet<T>::erase(MultiSet<T>::iterator, MultiSet<T>::iterator);                         \
+    PREFIX MultiSet<T>::node_type MultiSet<T>::extract(MultiSet<T>::iterator);                            \
+    PREFIX MultiSet<T>::node_type MultiSet<T>::extract(const T&);                                         \
+    PREFIX void MultiSet<T>::set_lazy_erase(bool, MultiSet<T>::size_type);                                \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::dead_count() const;                                        \
+    PREFIX void MultiSet<T>::compact();                                                                   \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::find(const T&) const;                                       \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::count(const T&) const;                                     \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::lower_bound(const T&) const;                                \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::find(MultiSet<T>::const_iterator, const T&) const;          \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::lower_bound(MultiSet<T>::const_iterator, const T&) const;   \
+    PREFIX void MultiSet<T>::set_finger_search(bool);                                                     \
+    PREFIX MultiSet<T>::iterator MultiSet<T>::upper_bound(const T&) const;                                \
+    PREFIX std::pair<MultiSet<T>::iterator, MultiSet<T>::iterator> MultiSet<T>::equal_range(const T&) const; \
+    PREFIX void MultiSet<T>::print(std::ostream&) const;                                                  \
+    PREFIX MultiSet<T>::MemoryStats MultiSet<T>::memory_stats() const;                                    \
+    PREFIX bool MultiSet<T>::is_balanced() const;                                                         \
+    PREFIX bool MultiSet<T>::defragment(MultiSet<T>::size_type, MultiSet<T>::DefragmentLayout, bool);     \
+    PREFIX bool MultiSet<T>::set_node_storage(MultiSet<T>::NodeStorage);                                  \
+    PREFIX const char* MultiSet<T>::node_storage_backing() const;                                         \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::live_nodes();                                              \
+    PREFIX MultiSet<T>::size_type MultiSet<T>::live_bytes();                                              \
+    PREFIX FrozenMultiSet<T> MultiSet<T>::freeze() const;                                                 \
+    PREFIX bool MultiSet<T>::save(std::ostream&) const;                                                   \
+    PREFIX bool MultiSet<T>::load(std::istream&);
+
+MULTISET_INSTANTIATE(extern template, int)
+MULTISET_INSTANTIATE(extern template, long)
+MULTISET_INSTANTIATE(extern template, double)
+MULTISET_INSTANTIATE(extern template, std::string)
+
+#endif /// __MULTI_SET_INSTANTIATION_HPP__
+
@@ -0,0 +1,120 @@
+#ifndef __MULTI_SET_INSTRUMENTATION_HPP__
+#define __MULTI_SET_INSTRUMENTATION_HPP__
+
+#include <cstddef>
+#include <stdint.h>
+
+/// Public MultiSet operations reported to a latency sampler.
+enum MultiSetOperation {
+    MULTISET_INSERT,
+    MULTISET_ERASE,
+    MULTISET_FIND,
+    MULTISET_COUNT,
+    MULTISET_LOWER_BOUND,
+    MULTISET_UPPER_BOUND,
+    MULTISET_RANGE_SCAN
+};
+
+/// Operations in an operation trace (see MultiSetTrace.hpp). Erase takes
+/// one element equal to the key, erase all every one; a range scan has the
+/// bounds of for_each_in_range as its two keys.
+enum MultiSetTraceOperation {
+    MULTISET_TRACE_INSERT,
+    MULTISET_TRACE_ERASE,
+    MULTISET_TRACE_ERASE_ALL,
+    MULTISET_TRACE_FIND,
+    MULTISET_TRACE_COUNT,
+    MULTISET_TRACE_LOWER_BOUND,
+    MULTISET_TRACE_UPPER_BOUND,
+    MULTISET_TRACE_RANGE_SCAN
+};
+
+struct MultiSetCounters {
+    uint64_t comparisons;
+    uint64_t rotations;
+    uint64_t retraceSteps;
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t iteratorSteps;
+};
+
+/// Instrument policies are the (empty) base of MultiSet, so their hooks are
+/// called on the set itself. Hooks are const because lookups are.
+/// Scope is constructed at the start of every public operation, and
+/// onTrace is then called with the operation's keys; nested operations
+/// (count calls lower_bound) report their keys too.
+
+/// Default policy: every hook is an empty inline function and the policy
+/// has no data, so an uninstrumented MultiSet is unchanged.
+class NoInstrumentation
+{
+public:
+    class Scope {
+    public:
+        Scope(const NoInstrumentation&, MultiSetOperation) {}
+    };
+
+    void onComparison(uint64_t = 1) const {}
+    void onRotation() const {}
+    void onRetraceStep() const {}
+    void onAllocation() const {}
+    void onFree() const {}
+    void onIteratorStep(uint64_t = 1) const {}
+    template <typename Key>
+    void onTrace(MultiSetTraceOperation, const Key&) const {}
+    template <typename Key>
+    void onTrace(MultiSetTraceOperation, const Key&, const Key&) const {}
+};
+
+/// Per-instance operation counters plus optional latency sampling.
+/// The sampler is called with the duration of every period-th outermost
+/// public operation; nested calls (count calls lower_bound) are not sampled.
+class CountingInstrumentation
+{
+public:
+    typedef void (*Sampler)(MultiSetOperation operation, uint64_t nanoseconds, void* context);
+
+    class Scope {
+    public:
+        Scope(const CountingInstrumentation& owner, MultiSetOperation operation);
+        ~Scope();
+    private:
+        Scope(const Scope&);
+        const Scope& operator=(const Scope&);
+    private:
+        const CountingInstrumentation& owner_;
+        MultiSetOperation operation_;
+        uint64_t start_;
+        bool isSampled_;
+    };
+
+    CountingInstrumentation();
+    const MultiSetCounters& counters() const;
+    void resetCounters();
+    void setLatencySampler(Sampler sampler, void* context = NULL, uint32_t period = 1);
+
+    void onComparison(uint64_t count = 1) const;
+    void onRotation() const;
+    void onRetraceStep() const;
+    void onAllocation() const;
+    void onFree() const;
+    void onIteratorStep(uint64_t count = 1) const;
+    template <typename Key>
+    void onTrace(MultiSetTraceOperation, const Key&) const {}
+    template <typename Key>
+    void onTrace(MultiSetTraceOperation, const Key&, const Key&) const {}
+
+private:
+    static uint64_t now();
+private:
+    mutable MultiSetCounters counters_;
+    Sampler sampler_;
+    void* samplerContext_;
+    uint32_t samplePeriod_;
+    mutable uint32_t untilSample_;
+    mutable uint32_t depth_;
+};
+
+#include "templates/MultiSetInstrumentation.cpp"
+#endif /// __MULTI_SET_INSTRUMENTATION_HPP__
+
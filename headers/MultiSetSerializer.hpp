@@ -0,0 +1,76 @@
+#ifndef __MULTI_SET_SERIALIZER_HPP__
+#define __MULTI_SET_SERIALIZER_HPP__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+/// Buffered binary output used by MultiSet::save. Bytes are collected in a
+/// large buffer and handed to the stream in big chunks.
+class MultiSetWriter
+{
+public:
+    explicit MultiSetWriter(std::ostream& out, std::size_t bufferSize = 1 << 20);
+    ~MultiSetWriter();
+    void write(const void* data, std::size_t size);
+    template <typename T>
+    void writeValue(const T& value);
+    bool flush();
+    bool good() const;
+private:
+    MultiSetWriter(const MultiSetWriter&);
+    const MultiSetWriter& operator=(const MultiSetWriter&);
+private:
+    std::ostream& out_;
+    std::vector<char> buffer_;
+    std::size_t used_;
+};
+
+/// Binary input used by MultiSet::load. Reads go straight to the stream
+/// buffer, so nothing past the end of the set is consumed. A short read
+/// leaves the requested bytes zeroed and sets failbit on the stream.
+class MultiSetReader
+{
+public:
+    explicit MultiSetReader(std::istream& in);
+    void read(void* data, std::size_t size);
+    template <typename T>
+    T readValue();
+    bool good() const;
+private:
+    MultiSetReader(const MultiSetReader&);
+    const MultiSetReader& operator=(const MultiSetReader&);
+private:
+    std::istream& in_;
+    bool good_;
+};
+
+static const char MULTI_SET_MAGIC[4] = { 'M', 'S', 'E', 'T' };
+static const uint32_t MULTI_SET_FORMAT_VERSION = 1;
+
+/// Encoding of a single element in the MultiSet binary format.
+/// The primary template copies the object representation and only accepts
+/// trivially copyable types; specialize it for anything else.
+/// elementSize() is stored in the file header and checked on load,
+/// 0 stands for variable-length encodings.
+template <typename Data>
+struct MultiSetSerializer
+{
+    static uint32_t elementSize();
+    static void write(MultiSetWriter& out, const Data& value);
+    static Data read(MultiSetReader& in);
+};
+
+template <>
+struct MultiSetSerializer<std::string>
+{
+    static uint32_t elementSize();
+    static void write(MultiSetWriter& out, const std::string& value);
+    static std::string read(MultiSetReader& in);
+};
+
+#include "templates/MultiSetSerializer.cpp"
+#endif /// __MULTI_SET_SERIALIZER_HPP__
+
@@ -0,0 +1,121 @@
+#ifndef __MULTI_SET_TRACE_HPP__
+#define __MULTI_SET_TRACE_HPP__
+
+#include "headers/MultiSetInstrumentation.hpp"
+#include "headers/MultiSetSerializer.hpp"
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+/// Binary operation trace: the header "MSTR", format version, key size
+/// (as in the MultiSet format) and MultiSetTraceKeyType, then per operation
+/// one byte of MultiSetTraceOperation followed by its keys in
+/// MultiSetSerializer encoding; two keys for a range scan, one otherwise.
+/// An int trace is 5 bytes per operation.
+static const char MULTI_SET_TRACE_MAGIC[4] = { 'M', 'S', 'T', 'R' };
+static const uint32_t MULTI_SET_TRACE_VERSION = 2;
+
+/// Key types a replay can decode; the key size alone cannot tell an int
+/// from a float or a long from a double. Other types are recorded as
+/// MULTISET_TRACE_KEY_OTHER and can only be read back by their own code.
+enum MultiSetTraceKeyType {
+    MULTISET_TRACE_KEY_OTHER,
+    MULTISET_TRACE_KEY_INT,
+    MULTISET_TRACE_KEY_LONG,
+    MULTISET_TRACE_KEY_LONG_LONG,
+    MULTISET_TRACE_KEY_DOUBLE,
+    MULTISET_TRACE_KEY_STRING
+};
+
+template <typename Data>
+struct MultiSetTraceKey { enum { TYPE = MULTISET_TRACE_KEY_OTHER }; };
+template <>
+struct MultiSetTraceKey<int> { enum { TYPE = MULTISET_TRACE_KEY_INT }; };
+template <>
+struct MultiSetTraceKey<long> { enum { TYPE = MULTISET_TRACE_KEY_LONG }; };
+template <>
+struct MultiSetTraceKey<long long> { enum { TYPE = MULTISET_TRACE_KEY_LONG_LONG }; };
+template <>
+struct MultiSetTraceKey<double> { enum { TYPE = MULTISET_TRACE_KEY_DOUBLE }; };
+template <>
+struct MultiSetTraceKey<std::string> { enum { TYPE = MULTISET_TRACE_KEY_STRING }; };
+
+template <typename Data>
+class MultiSetTraceRecorder
+{
+public:
+    explicit MultiSetTraceRecorder(std::ostream& out);
+    void record(MultiSetTraceOperation operation, const Data& key);
+    void record(MultiSetTraceOperation operation, const Data& lo, const Data& hi);
+    uint64_t operation_count() const;
+    bool flush();
+private:
+    MultiSetTraceRecorder(const MultiSetTraceRecorder&);
+    const MultiSetTraceRecorder& operator=(const MultiSetTraceRecorder&);
+private:
+    MultiSetWriter writer_;
+    uint64_t count_;
+};
+
+/// Reads a trace back one operation at a time. good() is false after a
+/// bad header, a header of another key type, or a truncated record; a clean end of the trace is not an
+/// error.
+template <typename Data>
+class MultiSetTraceReader
+{
+public:
+    explicit MultiSetTraceReader(std::istream& in);
+    /// hi is only set for a range scan.
+    bool next(MultiSetTraceOperation& operation, Data& key, Data& hi);
+    bool good() const;
+private:
+    MultiSetTraceReader(const MultiSetTraceReader&);
+    const MultiSetTraceReader& operator=(const MultiSetTraceReader&);
+private:
+    std::istream& in_;
+    MultiSetReader reader_;
+    bool good_;
+};
+
+/// Instrument policy that writes the outermost public operations of the
+/// set to a recorder. Recording is off until setTraceRecorder is given
+/// one; it then costs a depth counter and a buffered write per operation.
+/// A range erase is recorded as an erase of each element in the range.
+/// remove_if and whole-set operations are not recorded, and copies of the
+/// set start without a recorder.
+template <typename Data>
+class TracingInstrumentation
+{
+public:
+    class Scope {
+    public:
+        Scope(const TracingInstrumentation& owner, MultiSetOperation);
+        ~Scope();
+    private:
+        Scope(const Scope&);
+        const Scope& operator=(const Scope&);
+    private:
+        const TracingInstrumentation& owner_;
+    };
+
+    TracingInstrumentation();
+    void setTraceRecorder(MultiSetTraceRecorder<Data>* recorder);
+    MultiSetTraceRecorder<Data>* traceRecorder() const;
+
+    void onComparison(uint64_t = 1) const {}
+    void onRotation() const {}
+    void onRetraceStep() const {}
+    void onAllocation() const {}
+    void onFree() const {}
+    void onIteratorStep(uint64_t = 1) const {}
+    void onTrace(MultiSetTraceOperation operation, const Data& key) const;
+    void onTrace(MultiSetTraceOperation operation, const Data& lo, const Data& hi) const;
+
+private:
+    MultiSetTraceRecorder<Data>* recorder_;
+    mutable uint32_t depth_;
+};
+
+#include "templates/MultiSetTrace.cpp"
+#endif /// __MULTI_SET_TRACE_HPP__
+
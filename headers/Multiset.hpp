@@ -3,25 +3,61 @@
 
 #include <iostream>
 #include <utility>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <limits>
+#include "headers/MultiSetSerializer.hpp"
+#include "headers/MultiSetInstrumentation.hpp"
+#include "headers/MultiSetBalance.hpp"
+#include "headers/MultiSetAugment.hpp"
+#include "headers/FrozenMultiSet.hpp"
+#include "headers/NodeArena.hpp"
 
-template <typename Data>
-class MultiSet 
+/// Instrument is a policy from MultiSetInstrumentation.hpp. It is an empty
+/// base by default, so an uninstrumented set pays nothing for it.
+/// Balance is a policy from MultiSetBalance.hpp (AVL, red-black or
+/// weight-balanced) and decides what each node stores to stay balanced.
+/// Augment is a policy from MultiSetAugment.hpp; with one, every node also
+/// holds the aggregate of its subtree for range_aggregate.
+template <typename Data, typename Instrument = NoInstrumentation, typename Balance = AvlBalance,
+          typename Augment = NoAugment>
+class MultiSet : private Instrument
 {
-    template <typename T> friend std::ostream& operator<<(std::ostream& out, const MultiSet<T>& rhv);
+    template <typename T, typename I, typename B, typename A>
+    friend std::ostream& operator<<(std::ostream& out, const MultiSet<T, I, B, A>& rhv);
+    friend Balance;
 private:
-    struct Node {
+    struct Node : public MultiSetAggregate<typename Augment::value_type> {
         Node(const Data& data,
                    Node* parent = NULL,
                    Node* left = NULL,
                    Node* right = NULL)
             : data_(data)
+            , balance_(Balance::leafInfo())
             , parent_(parent), left_(left), right_(right)
         {}
         Data data_;
+        MultiSetBalanceInfo<typename Balance::Info> balance_;
         Node* parent_;
         Node* left_;
         Node* right_;
+#ifdef MULTISET_TRACK_MEMORY
+        static void* operator new(std::size_t size);
+        static void operator delete(void* ptr, std::size_t size);
+#endif /// MULTISET_TRACK_MEMORY
     };
+
+    struct Chunk {
+        Chunk(Node* root, bool isSingle)
+            : root_(root), isSingle_(isSingle)
+        {}
+        Node* root_;
+        bool isSingle_;
+    };
+
+    enum TraversalOrder { PRE_ORDER, IN_ORDER, POST_ORDER, LEVEL_ORDER };
 public:
     typedef Data value_type;
     typedef Data key_type;
@@ -30,10 +66,50 @@ public:
     typedef value_type* pointer;
     typedef std::ptrdiff_t difference_type;
     typedef std::size_t size_type;
+    typedef typename Augment::value_type aggregate_type;
+
+    struct MemoryStats {
+        size_type nodeCount;
+        size_type payloadBytes;
+        size_type pointerBytes;
+        /// Balance info (the lazy-erase mark included) and the aggregate, if any.
+        size_type metadataBytes;
+        size_type paddingBytes;
+        size_type allocatorSlackBytes;
+        size_type totalBytes;
+        int height;
+    };
+
+    enum DefragmentLayout { IN_ORDER_LAYOUT, VEB_LAYOUT };
+    enum NodeStorage { HEAP_STORAGE, ARENA_STORAGE, HUGE_PAGE_STORAGE };
+
+private:
+    /// One contiguous array of nodes that defragment moved nodes into.
+    struct NodeBlock {
+        Node* nodes_;
+        size_type capacity_;
+        size_type live_;
+    };
+
+    /// Blocks and the state of the running defragment pass, allocated on
+    /// the first call. While a pass runs, blocks_.back() is its target.
+    struct Relocation {
+        std::vector<NodeBlock> blocks_;
+        std::vector<char> isSlotUsed_;
+        Node* cursor_;
+        size_type nextSlot_;
+        int height_;
+        DefragmentLayout layout_;
+        bool isRunning_;
+    };
 
 private:
     static Node* getRightMost(Node* rhv);
     static Node* getLeftMost(Node* rhv);
+    static Node* successor(Node* rhv);
+    static Node* predecessor(Node* rhv);
+    static Node* nextNode(Node* rhv);
+    static Node* prevNode(Node* rhv);
 
 public:
     MultiSet();
@@ -56,7 +132,7 @@ public:
     bool operator>=(const MultiSet& rhv) const;
 
     class const_iterator {
-        friend class MultiSet<Data>; 
+        friend class MultiSet<Data, Instrument, Balance, Augment>; 
     public:
         const_iterator();
         const_iterator(const const_iterator& rhv);
@@ -84,8 +160,6 @@ public:
         void setParent(const_iterator it);
         void setLeft(const_iterator it);
         void setRight(const_iterator it);
-        void createLeft(const value_type& x);
-        void createRight(const value_type& x);
         const_iterator firstLeftParent() const;
         const_iterator firstRightParent() const;
         bool isLeftParent() const;
@@ -100,7 +174,7 @@ public:
     };
 
     class iterator : public const_iterator {
-        friend class MultiSet<Data>; 
+        friend class MultiSet<Data, Instrument, Balance, Augment>; 
     public:
         iterator();
         iterator(const iterator& rhv);
@@ -123,7 +197,7 @@ public:
     };
 
     class const_reverse_iterator {
-        friend class MultiSet<Data>; 
+        friend class MultiSet<Data, Instrument, Balance, Augment>; 
     public:
         const_reverse_iterator();
         const_reverse_iterator(const const_reverse_iterator& rhv);
@@ -152,7 +226,7 @@ public:
     };
     
     class reverse_iterator : public const_reverse_iterator {
-        friend class MultiSet<Data>;
+        friend class MultiSet<Data, Instrument, Balance, Augment>;
     public:
         reverse_iterator();
         reverse_iterator(const reverse_iterator& rhv);
@@ -169,6 +243,31 @@ public:
         reverse_iterator& goParent();
     };
 
+    /// Owns an element taken out of a set by extract. The value may be
+    /// changed while it is detached, and insert links the same node into
+    /// any set of this type again. A node from an arena keeps its slot and
+    /// the arena alive; only a set without that arena copies the value
+    /// into a node of its own.
+    class node_type {
+        friend class MultiSet<Data, Instrument, Balance, Augment>;
+    public:
+        node_type();
+        node_type(node_type&& rhv);
+        ~node_type();
+        node_type& operator=(node_type&& rhv);
+        bool empty() const;
+        explicit operator bool() const;
+        value_type& value() const;
+    private:
+        node_type(Node* node, NodeArena<Node>* arena);
+        node_type(const node_type&) = delete;
+        node_type& operator=(const node_type&) = delete;
+        void destroy();
+    private:
+        Node* node_;
+        NodeArena<Node>* arena_;
+    };
+
     iterator begin();
     iterator end();
     const_iterator begin() const;
@@ -180,18 +279,33 @@ public:
 
     iterator insert(const value_type& x);
     iterator insert(iterator pos, const value_type& x);
+    iterator insert(node_type&& node);
     template <typename InputIt>
     void insert(InputIt first, InputIt last);
 
     void erase(iterator pos);
     size_type erase(const key_type& k);
     void erase(iterator first, iterator last);
+    node_type extract(iterator pos);
+    node_type extract(const key_type& k);
+    template <typename Predicate>
+    size_type remove_if(Predicate pred);
+
+    void set_lazy_erase(bool isLazy, size_type compactThreshold = 0);
+    size_type dead_count() const;
+    void compact();
 
     iterator find(const key_type& k) const;
     size_type count(const key_type& k) const;
     iterator lower_bound(const key_type& k) const;
+    iterator find(const_iterator hint, const key_type& k) const;
+    iterator lower_bound(const_iterator hint, const key_type& k) const;
+    void set_finger_search(bool isEnabled);
     iterator upper_bound(const key_type& k) const;
     std::pair<iterator, iterator> equal_range(const key_type& k) const;
+    aggregate_type range_aggregate(const key_type& lo, const key_type& hi) const;
+    template <typename Function>
+    Function for_each_in_range(const key_type& lo, const key_type& hi, Function f) const;
     void print(std::ostream& out = std::cout) const;
     void preOrderIter(std::ostream& out = std::cout) const;
     void preOrderRec(std::ostream& out = std::cout) const;
@@ -200,28 +314,120 @@ public:
     void postOrderIter(std::ostream& out = std::cout) const;
     void postOrderRec(std::ostream& out = std::cout) const;
     void levelOrderIter(std::ostream& out = std::cout) const;
+
+    template <typename Visitor>
+    Visitor visit_preorder(Visitor visitor) const;
+    template <typename Visitor>
+    Visitor visit_inorder(Visitor visitor) const;
+    template <typename Visitor>
+    Visitor visit_postorder(Visitor visitor) const;
+    template <typename Visitor>
+    Visitor visit_levelorder(Visitor visitor) const;
+
+    template <typename Function>
+    void parallel_for_each(Function f, size_type threads = 0) const;
+    template <typename T, typename BinaryOp>
+    T parallel_reduce(T init, BinaryOp op, size_type threads = 0) const;
+    template <typename T, typename BinaryOp, typename CombineOp>
+    T parallel_reduce(T init, BinaryOp op, CombineOp combine, size_type threads) const;
+
+    const Instrument& instrumentation() const;
+    Instrument& instrumentation();
+    MemoryStats memory_stats() const;
+    bool is_balanced() const;
+    bool defragment(size_type maxNodes = std::numeric_limits<std::size_t>::max(),
+                    DefragmentLayout layout = IN_ORDER_LAYOUT, bool isRebalanced = false);
+    bool set_node_storage(NodeStorage storage);
+    const char* node_storage_backing() const;
+    static size_type live_nodes();
+    static size_type live_bytes();
+
+    FrozenMultiSet<Data> freeze() const;
+
+    bool save(std::ostream& out) const;
+    bool load(std::istream& in);
 private:
     void preOrderHelper(Node* root, std::ostream& out = std::cout) const;
     void inOrderHelper(Node* root, std::ostream& out = std::cout) const;
     void postOrderHelper(Node* root, std::ostream& out = std::cout) const;
     void outputTree(Node* ptr, std::ostream& out, const int totalSpaces = 0) const;
+    template <int ORDER, typename Visitor>
+    bool walkHelper(Visitor& visitor, int level) const;
     iterator findHelper(iterator root, const key_type& key) const;
     iterator boundHelper(iterator root, const key_type& key) const;
+    Node* fingerRoot(Node* hint, const key_type& key) const;
     void goUp(iterator& it, const value_type& x);
-    void goDownAndInsert(iterator& it, const value_type& x);
+    void goDownAndInsert(iterator& it, Node* node);
     void rotateRight(iterator& it);
     void rotateLeft(iterator& it);
-    void balance(iterator& it);
+    Node* rotateUp(Node* n);
+    void replaceChild(Node* parent, Node* oldChild, Node* newChild);
+    static aggregate_type aggregateOf(const Node* n);
+    static aggregate_type liftOf(const Node* n);
+    static void updateAggregate(Node* n);
+    static void updateAggregate(Node* n, std::true_type);
+    static void updateAggregate(Node* n, std::false_type);
+    static void refreshAggregates(Node* n);
     bool isRoot(const const_iterator& temp) const;
     void clearHelper(Node*& root); 
-    iterator insertHelper(iterator it, const value_type& x);
-    size_type eraseRangeHelper(iterator first, iterator last);
+    iterator insertHelper(iterator it, Node* node);
+    size_type eraseRangeHelper(iterator first, iterator last, bool traceEach);
+    void eraseNode(Node* posNode);
+    void unlinkNode(Node* posNode);
+    void compactIfNeeded();
+    template <typename Predicate>
+    size_type collectSurvivors(Node* root, std::vector<Node*>& nodes, Predicate& pred);
+    void relink(std::vector<Node*>& nodes);
+    static Node* linkBalanced(Node** nodes, size_type count, int depth, int maxDepth);
+    void splitHelper(Node* root, int levels, std::vector<Chunk>& chunks) const;
+    size_type splitChunks(size_type threads, std::vector<Chunk>& chunks) const;
+    template <typename Function>
+    static void forEachHelper(Node* root, Function& f);
+    template <typename T, typename BinaryOp>
+    static void reduceHelper(Node* root, T& result, BinaryOp& op);
+    template <typename Body>
+    static void runParallel(size_type tasks, size_type threads, Body body);
+    Node* loadHelper(MultiSetReader& in, uint64_t count, int depth, int maxDepth);
+    int statsHelper(Node* root, MemoryStats& stats) const;
+    size_type allocationSize(Node* node) const;
+    Node* allocateNode(const value_type& x);
+    void freeNode(Node* node);
+    bool isPooled(Node* node) const;
+    static void trackPooledNode(bool isAllocated);
+    NodeBlock* findBlock(Node* node) const;
+    void startDefragment(DefragmentLayout layout, bool isRebalanced);
+    void relocate(Node* node, Node* slot);
+    static uint64_t heapIndex(Node* node);
+    static size_type vebPosition(uint64_t heapIndex, int height);
 private:
     Node* root_;
+    size_type deadCount_;
+    /// 0 when erase unlinks at once; otherwise erase only marks nodes dead
+    /// and the tree is compacted once this many are dead.
+    size_type compactThreshold_;
+    /// Result of the last lower_bound when finger search is on; lookups
+    /// start from here instead of from root_.
+    mutable Node* finger_;
+    Relocation* relocation_;
+    /// Where new nodes come from; NULL for operator new.
+    NodeArena<Node>* arena_;
+    bool isFingerEnabled_;
+#ifdef MULTISET_TRACK_MEMORY
+    static std::atomic<size_type> liveNodes_;
+    static std::atomic<size_type> liveBytes_;
+#endif /// MULTISET_TRACK_MEMORY
 
 };
 
+template <typename Data, typename Instrument, typename Balance, typename Augment, typename Predicate>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+erase_if(MultiSet<Data, Instrument, Balance, Augment>& ms, Predicate pred);
+
 #include "templates/Multiset.cpp"
+/// With MULTISET_PREBUILT the common instantiations come from libMultiSet.
+#ifdef MULTISET_PREBUILT
+#include "headers/MultiSetInstantiation.hpp"
+#endif /// MULTISET_PREBUILT
 #endif /// __MULTI_SET_T_HPP__
 
 
@@ -0,0 +1,64 @@
+#ifndef __NODE_ARENA_HPP__
+#define __NODE_ARENA_HPP__
+
+#include <cstddef>
+#include <vector>
+
+/// Fixed-size slots for objects of type T, cut from 2 MB chunks. Freed
+/// slots are kept on a free list and reused; the chunks are returned only
+/// when the arena is destroyed. With isHugePages every chunk is one huge
+/// page: an explicit MAP_HUGETLB page if the system has any reserved,
+/// otherwise an aligned mapping advised with MADV_HUGEPAGE so that
+/// transparent huge pages can back it. Elsewhere chunks come from
+/// operator new.
+/// The arena is shared by its set and the node handles holding one of its
+/// slots: it starts with one user, and release destroys it once the last
+/// user lets go.
+template <typename T>
+class NodeArena
+{
+public:
+    enum { CHUNK_SIZE = 2 << 20 };
+
+public:
+    explicit NodeArena(bool isHugePages);
+    ~NodeArena();
+
+    void* allocate();
+    void deallocate(void* slot);
+    bool owns(const void* slot) const;
+
+    bool is_huge_pages() const;
+    /// "hugetlb", "madvise" or "heap": how the last chunk was obtained.
+    const char* backing() const;
+    std::size_t chunk_count() const;
+
+    void retain();
+    static void release(NodeArena* arena);
+
+private:
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+    char* allocateChunk();
+    void releaseChunk(char* chunk);
+
+private:
+    struct FreeSlot {
+        FreeSlot* next_;
+    };
+
+    enum { SLOT_SIZE = sizeof(T) < sizeof(FreeSlot) ? sizeof(FreeSlot) : sizeof(T) };
+
+    /// Sorted by address, so that owns is a binary search.
+    std::vector<char*> chunks_;
+    FreeSlot* free_;
+    char* next_;
+    char* end_;
+    bool isHugePages_;
+    const char* backing_;
+    std::size_t users_;
+};
+
+#include "templates/NodeArena.cpp"
+#endif /// __NODE_ARENA_HPP__
+
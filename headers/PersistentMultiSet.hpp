@@ -0,0 +1,142 @@
+#ifndef __PERSISTENT_MULTI_SET_HPP__
+#define __PERSISTENT_MULTI_SET_HPP__
+
+#include "headers/AvlAlgorithms.hpp"
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+
+/// Sorted multiset whose AVL nodes live in a memory-mapped file.
+/// Links are node offsets (slot numbers in the node area, 0 meaning none)
+/// instead of pointers, so the file can be mapped at any address and
+/// queried right after open without deserializing. Offset selects the
+/// width of the links: uint32_t for up to 4G nodes, uint64_t otherwise.
+/// Data must be trivially copyable, it is stored in the file as is.
+template <typename Data, typename Offset = uint64_t>
+class PersistentMultiSet
+{
+private:
+    struct Header {
+        char magic_[8];
+        uint32_t version_;
+        uint32_t nodeSize_;
+        uint32_t offsetSize_;
+        uint32_t reserved_;
+        uint64_t capacity_;
+        uint64_t used_;
+        uint64_t size_;
+        uint64_t root_;
+        uint64_t freeList_;
+    };
+
+    struct Node {
+        Data data_;
+        Offset parent_;
+        Offset left_;
+        Offset right_;
+        signed char balance_;
+    };
+
+    struct NodeTraits {
+        typedef Offset node_ptr;
+        explicit NodeTraits(Node* nodes) : nodes_(nodes) {}
+        Offset null() const { return 0; }
+        Offset parent(Offset n) const { return nodes_[n].parent_; }
+        Offset left(Offset n) const { return nodes_[n].left_; }
+        Offset right(Offset n) const { return nodes_[n].right_; }
+        int balance(Offset n) const { return nodes_[n].balance_; }
+        void setParent(Offset n, Offset p) const { nodes_[n].parent_ = p; }
+        void setLeft(Offset n, Offset l) const { nodes_[n].left_ = l; }
+        void setRight(Offset n, Offset r) const { nodes_[n].right_ = r; }
+        void setBalance(Offset n, int b) const { nodes_[n].balance_ = static_cast<signed char>(b); }
+        Node* nodes_;
+    };
+    typedef AvlAlgorithms<NodeTraits> Algorithms;
+
+    static_assert(std::is_trivially_copyable<Data>::value,
+                  "PersistentMultiSet stores Data in the file as is");
+    static_assert(std::is_unsigned<Offset>::value, "Offset must be an unsigned integer");
+    static_assert(sizeof(Header) == 64, "Header must fill the first 64 bytes of the file");
+
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+
+    class const_iterator {
+        friend class PersistentMultiSet<Data, Offset>;
+    public:
+        const_iterator();
+        const value_type& operator*() const;
+        const value_type* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator& rhv) const;
+        bool operator!=(const const_iterator& rhv) const;
+    private:
+        const_iterator(const PersistentMultiSet* set, Offset offset);
+    private:
+        const PersistentMultiSet* set_;
+        Offset offset_;
+    };
+    typedef const_iterator iterator;
+
+public:
+    PersistentMultiSet();
+    explicit PersistentMultiSet(const std::string& path, bool readOnly = false);
+    ~PersistentMultiSet();
+
+    bool open(const std::string& path, bool readOnly = false);
+    void close();
+    bool sync();
+    bool is_open() const;
+
+    size_type size() const;
+    bool empty() const;
+    void clear();
+    int height() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const_iterator insert(const value_type& x);
+    void erase(const_iterator pos);
+    size_type erase(const key_type& k);
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+private:
+    PersistentMultiSet(const PersistentMultiSet&);
+    const PersistentMultiSet& operator=(const PersistentMultiSet&);
+
+    Header* header() const;
+    Node* nodes() const;
+    NodeTraits traits() const;
+    static std::size_t fileSize(uint64_t capacity);
+    bool map(std::size_t bytes);
+    bool reserve(uint64_t capacity);
+    Offset allocateNode(const value_type& x);
+    void freeNode(Offset n);
+    bool checkHeader() const;
+    void initHeader(uint64_t capacity);
+
+private:
+    int fd_;
+    char* base_;
+    std::size_t mappedBytes_;
+    bool readOnly_;
+};
+
+#include "templates/PersistentMultiSet.cpp"
+#endif /// __PERSISTENT_MULTI_SET_HPP__
+
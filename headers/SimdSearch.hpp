@@ -0,0 +1,93 @@
+#ifndef __SIMD_SEARCH_HPP__
+#define __SIMD_SEARCH_HPP__
+
+#include <type_traits>
+#include <stdint.h>
+
+/// Vector kernels for one block of keys. Only the types below have them;
+/// the primary template marks everything else as unsupported.
+template <typename T>
+struct SimdKernels
+{
+    enum { SUPPORTED = 0 };
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MULTISET_SIMD_X86 1
+
+template <>
+struct SimdKernels<int32_t>
+{
+    enum { SUPPORTED = 1 };
+    static bool sseSupported();
+    static unsigned avx2Less(const int32_t* block, int32_t key);
+    static unsigned avx2LessEqual(const int32_t* block, int32_t key);
+    static unsigned sseLess(const int32_t* block, int32_t key);
+    static unsigned sseLessEqual(const int32_t* block, int32_t key);
+};
+
+template <>
+struct SimdKernels<int64_t>
+{
+    enum { SUPPORTED = 1 };
+    static bool sseSupported();
+    static unsigned avx2Less(const int64_t* block, int64_t key);
+    static unsigned avx2LessEqual(const int64_t* block, int64_t key);
+    static unsigned sseLess(const int64_t* block, int64_t key);
+    static unsigned sseLessEqual(const int64_t* block, int64_t key);
+};
+
+template <>
+struct SimdKernels<float>
+{
+    enum { SUPPORTED = 1 };
+    static bool sseSupported();
+    static unsigned avx2Less(const float* block, float key);
+    static unsigned avx2LessEqual(const float* block, float key);
+    static unsigned sseLess(const float* block, float key);
+    static unsigned sseLessEqual(const float* block, float key);
+};
+
+template <>
+struct SimdKernels<double>
+{
+    enum { SUPPORTED = 1 };
+    static bool sseSupported();
+    static unsigned avx2Less(const double* block, double key);
+    static unsigned avx2LessEqual(const double* block, double key);
+    static unsigned sseLess(const double* block, double key);
+    static unsigned sseLessEqual(const double* block, double key);
+};
+#endif /// x86
+
+/// Counts how many keys of a BLOCK-sized block (one cache line) are less
+/// than, or not greater than, a key. The widest kernel the CPU supports
+/// (AVX2, SSE, plain C++) is picked once through CPUID.
+template <typename T>
+class SimdSearch
+{
+public:
+    enum { BLOCK = 64 / sizeof(T) };
+    typedef unsigned (*Kernel)(const T* block, T key);
+
+    struct Kernels {
+        Kernel less_;
+        Kernel lessEqual_;
+        const char* name_;
+    };
+
+    static const Kernels& kernels();
+    static unsigned countLess(const T* block, T key);
+    static unsigned countLessEqual(const T* block, T key);
+    static const char* instructionSet();
+
+private:
+    static Kernels select(std::true_type);
+    static Kernels select(std::false_type);
+    static unsigned scalarLess(const T* block, T key);
+    static unsigned scalarLessEqual(const T* block, T key);
+};
+
+#include "templates/SimdSearch.cpp"
+#endif /// __SIMD_SEARCH_HPP__
+
@@ -0,0 +1,96 @@
+#ifndef __SMALL_MULTI_SET_HPP__
+#define __SMALL_MULTI_SET_HPP__
+
+#include "headers/Multiset.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/// Sorted multiset that keeps up to N elements inline, as a sorted array in
+/// the object itself, and moves them into a MultiSet on the heap once it
+/// grows past N. Lookups in the inline array are a binary search without
+/// any pointer chasing, and a set that stays small never allocates. The
+/// tree is kept until clear(), which goes back to the inline array.
+/// Iterators are invalidated by inserts and erases while inline, and by
+/// the insert that moves the elements into the tree.
+template <typename Data, std::size_t N = 16>
+class SmallMultiSet
+{
+private:
+    typedef MultiSet<Data> Tree;
+
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+
+    static const size_type INLINE_CAPACITY = N;
+
+    class const_iterator {
+        friend class SmallMultiSet<Data, N>;
+    public:
+        const_iterator();
+        const value_type& operator*() const;
+        const value_type* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator& rhv) const;
+        bool operator!=(const const_iterator& rhv) const;
+    private:
+        const_iterator(const SmallMultiSet* set, size_type index);
+        const_iterator(const SmallMultiSet* set, typename Tree::iterator node);
+    private:
+        const SmallMultiSet* set_;
+        /// Position in the inline array; unused once the set is a tree.
+        size_type index_;
+        typename Tree::iterator node_;
+    };
+    typedef const_iterator iterator;
+
+public:
+    SmallMultiSet();
+    SmallMultiSet(const SmallMultiSet& rhv);
+    template <typename InputIterator>
+    SmallMultiSet(InputIterator first, InputIterator last);
+    ~SmallMultiSet();
+    const SmallMultiSet& operator=(const SmallMultiSet& rhv);
+    void swap(SmallMultiSet& rhv);
+
+    size_type size() const;
+    bool empty() const;
+    bool is_inline() const;
+    void clear();
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const_iterator insert(const value_type& x);
+    void erase(const_iterator pos);
+    size_type erase(const key_type& k);
+
+    const_iterator find(const key_type& k) const;
+    size_type count(const key_type& k) const;
+    const_iterator lower_bound(const key_type& k) const;
+    const_iterator upper_bound(const key_type& k) const;
+    std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+private:
+    value_type* elements();
+    const value_type* elements() const;
+    void moveToTree();
+    void destroyInline();
+
+private:
+    typename std::aligned_storage<sizeof(Data) * N, std::alignment_of<Data>::value>::type buffer_;
+    size_type size_;
+    /// NULL while the elements are inline.
+    Tree* tree_;
+};
+
+#include "templates/SmallMultiSet.cpp"
+#endif /// __SMALL_MULTI_SET_HPP__
+
@@ -0,0 +1,89 @@
+#ifndef __STATIC_MULTI_SET_HPP__
+#define __STATIC_MULTI_SET_HPP__
+
+#include <cstddef>
+#include <utility>
+
+/// Sorted multiset of at most N elements held in an array inside the
+/// object; it never allocates. For a literal Data the set can be built at
+/// compile time from a list of elements in any order,
+///     constexpr StaticMultiSet<int, 4> table{ 7, 2, 7 };
+/// and find, lower_bound, upper_bound and count are constexpr as well.
+/// Data must be default constructible and copy assignable, and ordered by
+/// operator<. An insert into a full set returns end() and changes nothing.
+template <typename Data, std::size_t N>
+class StaticMultiSet
+{
+public:
+    typedef Data value_type;
+    typedef Data key_type;
+    typedef const value_type& const_reference;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+    typedef const value_type* const_iterator;
+    typedef const_iterator iterator;
+
+    static const size_type CAPACITY = N;
+
+private:
+    template <std::size_t... Is>
+    struct Indices {};
+    template <std::size_t K, std::size_t... Is>
+    struct MakeIndices : MakeIndices<K - 1, K - 1, Is...> {};
+    template <std::size_t... Is>
+    struct MakeIndices<0, Is...> { typedef Indices<Is...> type; };
+
+    /// The unsorted constructor arguments, so that they can be indexed.
+    template <std::size_t K>
+    struct Values {
+        Data values_[K];
+    };
+
+public:
+    constexpr StaticMultiSet();
+    template <typename... Args>
+    constexpr StaticMultiSet(const Data& first, const Args&... rest);
+
+    constexpr size_type size() const;
+    constexpr bool empty() const;
+    constexpr size_type max_size() const;
+    void clear();
+
+    constexpr const_iterator begin() const;
+    constexpr const_iterator end() const;
+
+    const_iterator insert(const value_type& x);
+    void erase(const_iterator pos);
+    size_type erase(const key_type& k);
+
+    constexpr const_iterator find(const key_type& k) const;
+    constexpr size_type count(const key_type& k) const;
+    constexpr const_iterator lower_bound(const key_type& k) const;
+    constexpr const_iterator upper_bound(const key_type& k) const;
+    constexpr std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+
+private:
+    template <std::size_t K, std::size_t... Is>
+    constexpr StaticMultiSet(Indices<Is...>, const Values<K>& values);
+
+    constexpr size_type lowerIndex(const key_type& k, size_type first, size_type count) const;
+    constexpr size_type upperIndex(const key_type& k, size_type first, size_type count) const;
+    constexpr const_iterator findHelper(const key_type& k, size_type index) const;
+
+    template <std::size_t K>
+    static constexpr size_type countLess(const Values<K>& v, const Data& x, size_type i);
+    template <std::size_t K>
+    static constexpr size_type countEqualBefore(const Values<K>& v, size_type j, size_type i);
+    template <std::size_t K>
+    static constexpr size_type rank(const Values<K>& v, size_type j);
+    template <std::size_t K>
+    static constexpr Data nth(const Values<K>& v, size_type n, size_type j);
+
+private:
+    Data data_[N];
+    size_type size_;
+};
+
+#include "templates/StaticMultiSet.cpp"
+#endif /// __STATIC_MULTI_SET_HPP__
+
@@ -0,0 +1,411 @@
+#include "headers/LatencyHistogram.hpp"
+#include "headers/Multiset.hpp"
+#include "headers/SmallMultiSet.hpp"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// Hardware counters of this thread through perf_event_open, read around a
+/// timed loop and reported per iteration by report(). Benchmarks count
+/// nothing unless MULTISET_PERF_COUNTERS is set: to 1 or all for every
+/// event, or to a comma separated list of the names below. Each event has
+/// its own counter and is scaled up for the time the PMU multiplexed it
+/// out; events that perf does not permit or the CPU lacks are left out.
+class PerfCounters
+{
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, EVENT_COUNT };
+
+    static const char* name(int event)
+    {
+        static const char* const NAMES[EVENT_COUNT] = {
+            "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses", "dTLB-misses"
+        };
+        return NAMES[event];
+    }
+
+    /// Bit mask of the events named in MULTISET_PERF_COUNTERS.
+    static unsigned requestedEvents()
+    {
+        const char* const value = std::getenv("MULTISET_PERF_COUNTERS");
+        if (NULL == value || '\0' == *value || 0 == std::strcmp(value, "0")) { return 0; }
+        if (0 == std::strcmp(value, "1") || 0 == std::strcmp(value, "all")) { return (1u << EVENT_COUNT) - 1; }
+        unsigned events = 0;
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (std::strstr(value, name(event)) != NULL) { events |= 1u << event; }
+        }
+        return events;
+    }
+
+    explicit PerfCounters(unsigned events = requestedEvents())
+        : opened_(0)
+    {
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            fds_[event] = -1;
+            values_[event] = 0;
+#if defined(__linux__)
+            if (0 == (events & (1u << event))) { continue; }
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            configure(event, attr);
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds_[event] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[event] >= 0) { ++opened_; }
+#endif /// __linux__
+        }
+        if (events != 0 && 0 == opened_) { warnUnavailable(); }
+    }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (fds_[event] >= 0) { ::close(fds_[event]); }
+        }
+#endif /// __linux__
+    }
+
+    bool is_available(int event) const { return fds_[event] >= 0; }
+
+    void start()
+    {
+#if defined(__linux__)
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (fds_[event] < 0) { continue; }
+            ::ioctl(fds_[event], PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fds_[event], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif /// __linux__
+    }
+
+    void stop()
+    {
+#if defined(__linux__)
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (fds_[event] < 0) { continue; }
+            ::ioctl(fds_[event], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3] = { 0, 0, 0 }; /// value, time enabled, time running
+            values_[event] = 0;
+            if (::read(fds_[event], data, sizeof(data)) == sizeof(data) && data[2] != 0) {
+                values_[event] = static_cast<double>(data[0]) * data[1] / data[2];
+            }
+        }
+#endif /// __linux__
+    }
+
+    /// Count of the last start()/stop() interval; 0 for an event not opened.
+    double value(int event) const { return values_[event]; }
+
+    /// Stops counting and adds "<event>/op" counters, and IPC when both
+    /// cycles and instructions were counted, to the benchmark.
+    void report(benchmark::State& state)
+    {
+        if (0 == opened_) { return; }
+        stop();
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (!is_available(event)) { continue; }
+            state.counters[std::string(name(event)) + "/op"]
+                = benchmark::Counter(values_[event], benchmark::Counter::kAvgIterations);
+        }
+        if (is_available(CYCLES) && is_available(INSTRUCTIONS) && values_[CYCLES] > 0) {
+            state.counters["IPC"] = values_[INSTRUCTIONS] / values_[CYCLES];
+        }
+    }
+
+private:
+    PerfCounters(const PerfCounters&);
+    const PerfCounters& operator=(const PerfCounters&);
+
+#if defined(__linux__)
+    static void configure(int event, perf_event_attr& attr)
+    {
+        static const uint64_t READ_MISS = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (event) {
+        case CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case L1D_MISSES: attr.type = PERF_TYPE_HW_CACHE; attr.config = PERF_COUNT_HW_CACHE_L1D | READ_MISS; break;
+        case LLC_MISSES: attr.type = PERF_TYPE_HW_CACHE; attr.config = PERF_COUNT_HW_CACHE_LL | READ_MISS; break;
+        case BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case DTLB_MISSES: attr.type = PERF_TYPE_HW_CACHE; attr.config = PERF_COUNT_HW_CACHE_DTLB | READ_MISS; break;
+        }
+    }
+#endif /// __linux__
+
+    /// Once per run, so that a missing perf does not go unnoticed.
+    static void warnUnavailable()
+    {
+        static bool warned = false;
+        if (warned) { return; }
+        warned = true;
+        std::fprintf(stderr, "perf_event_open is not available, hardware counters are not reported\n");
+    }
+
+private:
+    int fds_[EVENT_COUNT];
+    double values_[EVENT_COUNT];
+    int opened_;
+};
+
+/// Read/write mixes on a set of state.range(0) keys: state.range(1) percent
+/// of the operations are finds, the rest erase one present key and insert a
+/// new one, so the size stays fixed.
+template <typename Set>
+static void
+fillSet(Set& ms, std::vector<int>& keys, int size)
+{
+    std::srand(size);
+    for (int i = 0; i < size; ++i) {
+        keys.push_back(std::rand());
+        ms.insert(keys.back());
+    }
+}
+
+template <typename Set>
+static void
+runMix(benchmark::State& state, Set& ms, std::vector<int>& keys)
+{
+    const int readPercent = static_cast<int>(state.range(1));
+    std::size_t victim = 0;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        const int key = keys[std::rand() % keys.size()];
+        if (std::rand() % 100 < readPercent) {
+            benchmark::DoNotOptimize(ms.find(key));
+        } else {
+            ms.erase(ms.find(keys[victim]));
+            keys[victim] = std::rand();
+            ms.insert(keys[victim]);
+            victim = (victim + 1) % keys.size();
+        }
+    }
+    perf.report(state);
+    state.counters["height"] = ms.memory_stats().height;
+}
+
+template <typename Balance>
+static void
+BM_Mix(benchmark::State& state)
+{
+    MultiSet<int, NoInstrumentation, Balance> ms;
+    std::vector<int> keys;
+    fillSet(ms, keys, static_cast<int>(state.range(0)));
+    runMix(state, ms, keys);
+}
+
+/// Same mixes with rotations and retrace steps counted per operation.
+template <typename Balance>
+static void
+BM_MixRotations(benchmark::State& state)
+{
+    MultiSet<int, CountingInstrumentation, Balance> ms;
+    std::vector<int> keys;
+    fillSet(ms, keys, static_cast<int>(state.range(0)));
+    ms.instrumentation().resetCounters();
+    runMix(state, ms, keys);
+    const MultiSetCounters& counters = ms.instrumentation().counters();
+    state.counters["rotations"] = benchmark::Counter(counters.rotations, benchmark::Counter::kAvgIterations);
+    state.counters["retrace"] = benchmark::Counter(counters.retraceSteps, benchmark::Counter::kAvgIterations);
+}
+
+static void
+mixes(benchmark::internal::Benchmark* b)
+{
+    const int sizes[] = { 1 << 10, 1 << 16, 1 << 20 };
+    const int readPercents[] = { 90, 50, 10 };
+    for (int size : sizes) {
+        for (int readPercent : readPercents) { b->Args({ size, readPercent }); }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Mix, AvlBalance)->Apply(mixes);
+BENCHMARK_TEMPLATE(BM_Mix, RedBlackBalance)->Apply(mixes);
+BENCHMARK_TEMPLATE(BM_Mix, WeightBalance)->Apply(mixes);
+BENCHMARK_TEMPLATE(BM_MixRotations, AvlBalance)->Apply(mixes);
+BENCHMARK_TEMPLATE(BM_MixRotations, RedBlackBalance)->Apply(mixes);
+BENCHMARK_TEMPLATE(BM_MixRotations, WeightBalance)->Apply(mixes);
+
+/// Lookups with locality on the even keys 0, 2, ... of a set of
+/// state.range(0) elements: a sequential sweep (state.range(1) == 0) or a
+/// random walk with steps of up to state.range(1) keys. MODE 0 searches
+/// from the root, 1 passes the previous result as hint and 2 uses the
+/// set's own finger.
+template <int MODE>
+static void
+BM_Locality(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    const int step = static_cast<int>(state.range(1));
+    MultiSet<int> ms;
+    for (int i = 0; i < size; ++i) { ms.insert(2 * i); }
+    ms.set_finger_search(2 == MODE);
+    std::srand(size);
+    MultiSet<int>::iterator previous = ms.begin();
+    int key = size;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        key += (0 == step) ? 2 : 2 * (std::rand() % (2 * step + 1) - step);
+        key = (key % (2 * size) + 2 * size) % (2 * size);
+        previous = (1 == MODE) ? ms.lower_bound(previous, key) : ms.lower_bound(key);
+        benchmark::DoNotOptimize(previous);
+    }
+    perf.report(state);
+}
+
+static void
+localities(benchmark::internal::Benchmark* b)
+{
+    const int sizes[] = { 1 << 16, 1 << 20 };
+    const int steps[] = { 0, 16, 1024 };
+    for (int size : sizes) {
+        for (int step : steps) { b->Args({ size, step }); }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Locality, 0)->Apply(localities);
+BENCHMARK_TEMPLATE(BM_Locality, 1)->Apply(localities);
+BENCHMARK_TEMPLATE(BM_Locality, 2)->Apply(localities);
+
+/// Random finds in a set of state.range(0) random keys whose nodes come
+/// from the heap, an arena, or an arena on huge pages (state.range(1)).
+/// Always counts dTLB read misses per find, whether or not
+/// MULTISET_PERF_COUNTERS asks for them.
+static void
+BM_LookupStorage(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    MultiSet<int> ms;
+    ms.set_node_storage(static_cast<MultiSet<int>::NodeStorage>(state.range(1)));
+    std::vector<int> keys;
+    fillSet(ms, keys, size);
+    PerfCounters perf(PerfCounters::requestedEvents() | 1u << PerfCounters::DTLB_MISSES);
+    std::size_t next = 0;
+    perf.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ms.find(keys[next]));
+        next = (next + 7919) % keys.size();
+    }
+    perf.report(state);
+    state.SetLabel(std::string(ms.node_storage_backing()) + (perf.is_available(PerfCounters::DTLB_MISSES) ? "" : ", no perf"));
+}
+
+static void
+storages(benchmark::internal::Benchmark* b)
+{
+    const int sizes[] = { 1 << 20, 1 << 22 };
+    for (int size : sizes) {
+        for (int storage = MultiSet<int>::HEAP_STORAGE; storage <= MultiSet<int>::HUGE_PAGE_STORAGE; ++storage) {
+            b->Args({ size, storage });
+        }
+    }
+}
+
+BENCHMARK(BM_LookupStorage)->Apply(storages);
+
+/// Finds spread over many sets of state.range(0) elements each, as when
+/// sets are the values of another container.
+template <typename Set>
+static void
+BM_TinySets(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0));
+    std::vector<Set> sets(1 << 16);
+    std::srand(size);
+    for (Set& set : sets) {
+        for (int i = 0; i < size; ++i) { set.insert(std::rand() % 64); }
+    }
+    std::size_t next = 0;
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sets[next].find(static_cast<int>(next % 64)) == sets[next].end());
+        next = (next + 7919) % sets.size();
+    }
+    perf.report(state);
+}
+
+BENCHMARK_TEMPLATE(BM_TinySets, MultiSet<int>)->Arg(2)->Arg(8)->Arg(16);
+BENCHMARK_TEMPLATE(BM_TinySets, SmallMultiSet<int, 16>)->Arg(2)->Arg(8)->Arg(16);
+
+/// Times every single operation of a mix on a set of state.range(0) keys:
+/// state.range(1) percent finds, the rest split between inserting a new
+/// key and erasing a present one. Reports p50/p99/p99.9/max per operation
+/// in nanoseconds, and how long clearing the whole set takes.
+template <typename Set>
+static void
+BM_TailLatency(benchmark::State& state)
+{
+    typedef std::chrono::steady_clock Clock;
+    const int findPercent = static_cast<int>(state.range(1));
+    Set ms;
+    std::vector<int> keys;
+    fillSet(ms, keys, static_cast<int>(state.range(0)));
+    LatencyHistogram latencies[3];
+    PerfCounters perf;
+    perf.start();
+    for (auto _ : state) {
+        const int dice = std::rand() % 100;
+        const std::size_t victim = std::rand() % keys.size();
+        const int operation = dice < findPercent ? 0 : (dice - findPercent) % 2 + 1;
+        const Clock::time_point start = Clock::now();
+        if (0 == operation) {
+            benchmark::DoNotOptimize(ms.find(keys[victim]));
+        } else if (1 == operation || 1 == keys.size()) {
+            keys.push_back(std::rand());
+            ms.insert(keys.back());
+        } else {
+            ms.erase(ms.find(keys[victim]));
+        }
+        latencies[operation].record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        if (2 == operation && keys.size() > 1) {
+            keys[victim] = keys.back();
+            keys.pop_back();
+        }
+    }
+    perf.report(state);
+    const char* const names[] = { "find", "insert", "erase" };
+    for (int i = 0; i < 3; ++i) {
+        if (0 == latencies[i].count()) { continue; }
+        const std::string name = names[i];
+        state.counters[name + "_p50"] = static_cast<double>(latencies[i].percentile(50));
+        state.counters[name + "_p99"] = static_cast<double>(latencies[i].percentile(99));
+        state.counters[name + "_p99.9"] = static_cast<double>(latencies[i].percentile(99.9));
+        state.counters[name + "_max"] = static_cast<double>(latencies[i].max());
+    }
+    const Clock::time_point start = Clock::now();
+    ms.clear();
+    state.counters["clear_us"] = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+static void
+tailMixes(benchmark::internal::Benchmark* b)
+{
+    const int sizes[] = { 1 << 16, 1 << 20 };
+    const int findPercents[] = { 90, 50, 0 };
+    for (int size : sizes) {
+        for (int findPercent : findPercents) { b->Args({ size, findPercent }); }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_TailLatency, MultiSet<int>)->Apply(tailMixes);
+BENCHMARK_TEMPLATE(BM_TailLatency, std::multiset<int>)->Apply(tailMixes);
+
+BENCHMARK_MAIN();
+
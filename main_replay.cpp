@@ -0,0 +1,201 @@
+#include "headers/CompactMultiSet.hpp"
+#include "headers/LatencyHistogram.hpp"
+#include "headers/Multiset.hpp"
+#include "headers/MultiSetTrace.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+/// Replays a trace written by MultiSetTraceRecorder against MultiSet
+/// configurations and other engines and reports per-operation latencies.
+///     replay_MultiSet trace [engine...]
+/// Traces of int, long, long long, double and std::string keys are
+/// accepted, told apart by the key type in the header. Without engines all of them are run.
+
+static const char* const ENGINES[] = {
+    "avl", "redblack", "weight", "lazy", "finger", "arena", "hugepages", "compact", "std"
+};
+
+static const char* const OPERATION_NAMES[] = {
+    "insert", "erase", "erase_all", "find", "count", "lower_bound", "upper_bound", "range_scan"
+};
+
+template <typename Data>
+struct TraceRecord {
+    MultiSetTraceOperation operation;
+    Data key;
+    Data hi;
+};
+
+/// Keeps the results of lookups alive.
+static volatile std::size_t sink = 0;
+
+struct CountVisits {
+    template <typename Data>
+    void operator()(const Data&) { ++visits; }
+    std::size_t visits;
+};
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+static std::size_t
+scanRange(const MultiSet<Data, Instrument, Balance, Augment>& ms, const Data& lo, const Data& hi)
+{
+    const CountVisits counter = { 0 };
+    return ms.for_each_in_range(lo, hi, counter).visits;
+}
+
+template <typename Set, typename Data>
+static std::size_t
+scanRange(const Set& ms, const Data& lo, const Data& hi)
+{
+    std::size_t visits = 0;
+    for (typename Set::const_iterator it = ms.lower_bound(lo); it != ms.end() && !(hi < *it); ++it) { ++visits; }
+    return visits;
+}
+
+template <typename Set, typename Data>
+static void
+apply(Set& ms, const TraceRecord<Data>& record)
+{
+    switch (record.operation) {
+    case MULTISET_TRACE_INSERT: ms.insert(record.key); break;
+    case MULTISET_TRACE_ERASE: {
+        const typename Set::iterator it = ms.find(record.key);
+        if (it != ms.end()) { ms.erase(it); }
+        break;
+    }
+    case MULTISET_TRACE_ERASE_ALL: sink += ms.erase(record.key); break;
+    case MULTISET_TRACE_FIND: sink += ms.find(record.key) != ms.end(); break;
+    case MULTISET_TRACE_COUNT: sink += ms.count(record.key); break;
+    case MULTISET_TRACE_LOWER_BOUND: sink += ms.lower_bound(record.key) != ms.end(); break;
+    case MULTISET_TRACE_UPPER_BOUND: sink += ms.upper_bound(record.key) != ms.end(); break;
+    case MULTISET_TRACE_RANGE_SCAN: sink += scanRange(ms, record.key, record.hi); break;
+    }
+}
+
+template <typename Set, typename Data>
+static void
+replay(const std::string& engine, Set& ms, const std::vector<TraceRecord<Data> >& trace)
+{
+    typedef std::chrono::steady_clock Clock;
+    LatencyHistogram latencies[MULTISET_TRACE_RANGE_SCAN + 1];
+    const Clock::time_point begin = Clock::now();
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const Clock::time_point start = Clock::now();
+        apply(ms, trace[i]);
+        const uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        latencies[trace[i].operation].record(nanoseconds);
+    }
+    const double total = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    std::cout << engine << ": " << trace.size() << " operations in " << std::fixed << std::setprecision(1)
+              << total << " ms, " << ms.size() << " elements left\n";
+    std::cout << std::setw(14) << "operation" << std::setw(12) << "count" << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+              << std::setw(12) << "max (ns)\n";
+    for (int i = 0; i <= MULTISET_TRACE_RANGE_SCAN; ++i) {
+        const LatencyHistogram& h = latencies[i];
+        if (0 == h.count()) { continue; }
+        std::cout << std::setw(14) << OPERATION_NAMES[i] << std::setw(12) << h.count() << std::setw(10)
+                  << std::setprecision(0) << h.mean() << std::setw(10) << h.percentile(50) << std::setw(10)
+                  << h.percentile(99) << std::setw(10) << h.percentile(99.9) << std::setw(11) << h.max() << '\n';
+    }
+    std::cout << std::endl;
+}
+
+template <typename Data>
+static bool
+runEngine(const std::string& engine, const std::vector<TraceRecord<Data> >& trace)
+{
+    if ("avl" == engine) {
+        MultiSet<Data> ms;
+        replay(engine, ms, trace);
+    } else if ("redblack" == engine) {
+        MultiSet<Data, NoInstrumentation, RedBlackBalance> ms;
+        replay(engine, ms, trace);
+    } else if ("weight" == engine) {
+        MultiSet<Data, NoInstrumentation, WeightBalance> ms;
+        replay(engine, ms, trace);
+    } else if ("lazy" == engine) {
+        MultiSet<Data> ms;
+        ms.set_lazy_erase(true);
+        replay(engine, ms, trace);
+    } else if ("finger" == engine) {
+        MultiSet<Data> ms;
+        ms.set_finger_search(true);
+        replay(engine, ms, trace);
+    } else if ("arena" == engine || "hugepages" == engine) {
+        MultiSet<Data> ms;
+        ms.set_node_storage("arena" == engine ? MultiSet<Data>::ARENA_STORAGE : MultiSet<Data>::HUGE_PAGE_STORAGE);
+        replay(engine, ms, trace);
+    } else if ("compact" == engine) {
+        CompactMultiSet<Data> ms;
+        replay(engine, ms, trace);
+    } else if ("std" == engine) {
+        std::multiset<Data> ms;
+        replay(engine, ms, trace);
+    } else {
+        std::cerr << "Unknown engine " << engine << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename Data>
+static int
+run(std::istream& in, const std::vector<std::string>& engines)
+{
+    MultiSetTraceReader<Data> reader(in);
+    std::vector<TraceRecord<Data> > trace;
+    TraceRecord<Data> record;
+    while (reader.next(record.operation, record.key, record.hi)) { trace.push_back(record); }
+    if (!reader.good()) {
+        std::cerr << "Corrupt trace after " << trace.size() << " operations" << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < engines.size(); ++i) {
+        if (!runEngine(engines[i], trace)) { return 1; }
+    }
+    return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trace [engine...]\nEngines:";
+        for (const char* engine : ENGINES) { std::cerr << ' ' << engine; }
+        std::cerr << std::endl;
+        return 2;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    char header[sizeof(MULTI_SET_TRACE_MAGIC) + 3 * sizeof(uint32_t)];
+    uint32_t version = 0;
+    if (in.read(header, sizeof(header))) {
+        std::memcpy(&version, header + sizeof(MULTI_SET_TRACE_MAGIC), sizeof(version));
+    }
+    if (!in || 0 != std::memcmp(header, MULTI_SET_TRACE_MAGIC, sizeof(MULTI_SET_TRACE_MAGIC))
+        || version != MULTI_SET_TRACE_VERSION) {
+        std::cerr << argv[1] << " is not a MultiSet trace of version " << MULTI_SET_TRACE_VERSION << std::endl;
+        return 1;
+    }
+    uint32_t keyType = 0;
+    std::memcpy(&keyType, header + sizeof(MULTI_SET_TRACE_MAGIC) + 2 * sizeof(uint32_t), sizeof(keyType));
+    in.seekg(0);
+    std::vector<std::string> engines(argv + 2, argv + argc);
+    if (engines.empty()) { engines.assign(ENGINES, ENGINES + sizeof(ENGINES) / sizeof(ENGINES[0])); }
+    switch (keyType) {
+    case MULTISET_TRACE_KEY_INT: return run<int>(in, engines);
+    case MULTISET_TRACE_KEY_LONG: return run<long>(in, engines);
+    case MULTISET_TRACE_KEY_LONG_LONG: return run<long long>(in, engines);
+    case MULTISET_TRACE_KEY_DOUBLE: return run<double>(in, engines);
+    case MULTISET_TRACE_KEY_STRING: return run<std::string>(in, engines);
+    }
+    std::cerr << "No replay for the key type of " << argv[1] << " (" << keyType << ")" << std::endl;
+    return 1;
+}
+
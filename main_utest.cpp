@@ -1,11 +1,27 @@
+#define MULTISET_TRACK_MEMORY
 #include "headers/Multiset.hpp"
+#include "headers/LatencyHistogram.hpp"
+#include "headers/MultiSetTrace.hpp"
+#include "headers/PersistentMultiSet.hpp"
+#include "headers/FrozenBlockMultiSet.hpp"
+#include "headers/CompactMultiSet.hpp"
+#include "headers/IntrusiveMultiSet.hpp"
+#include "headers/SmallMultiSet.hpp"
+#include "headers/StaticMultiSet.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 ///==================== COUNT ====================
 TEST(MultisetTest, CountDuplicates) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(5);
     ms.insert(5);
     ms.insert(3);
@@ -16,32 +32,32 @@ TEST(MultisetTest, CountDuplicates) {
 
 ///==================== LOWER_BOUND ====================
 TEST(MultisetTest, LowerBoundWorksCorrectly) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(2);
     ms.insert(4);
     ms.insert(4);
     ms.insert(6);
-    Multiset<int>::iterator it = ms.lower_bound(4);
+    MultiSet<int>::iterator it = ms.lower_bound(4);
     EXPECT_EQ(it == ms.end(), false);
     EXPECT_EQ(*it >= 4, true);
 }
 
 TEST(MultisetTest, LowerBoundNoSuchElement) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(1);
     ms.insert(2);
-    Multiset<int>::iterator it = ms.lower_bound(5);
+    MultiSet<int>::iterator it = ms.lower_bound(5);
     EXPECT_EQ(it == ms.end(), true);
 }
 
 ///==================== UPPER_BOUND ====================
 TEST(MultisetTest, UpperBoundSkipsEqualKeys) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(2);
     ms.insert(4);
     ms.insert(4);
     ms.insert(6);
-    Multiset<int>::iterator it = ms.upper_bound(4);
+    MultiSet<int>::iterator it = ms.upper_bound(4);
     if (it != ms.end()) {
         EXPECT_EQ(*it > 4, true);
     } else {
@@ -51,13 +67,13 @@ TEST(MultisetTest, UpperBoundSkipsEqualKeys) {
 
 ///==================== EQUAL_RANGE ====================
 TEST(MultisetTest, EqualRangeReturnsCorrectPair) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(3);
     ms.insert(3);
     ms.insert(4);
-    std::pair<Multiset<int>::iterator, Multiset<int>::iterator> range = ms.equal_range(3);
+    std::pair<MultiSet<int>::iterator, MultiSet<int>::iterator> range = ms.equal_range(3);
     int count = 0;
-    for (Multiset<int>::iterator it = range.first; it != range.second; ++it) {
+    for (MultiSet<int>::iterator it = range.first; it != range.second; ++it) {
         ++count;
     }
     EXPECT_EQ(count, 2);
@@ -65,7 +81,7 @@ TEST(MultisetTest, EqualRangeReturnsCorrectPair) {
 
 ///==================== ERASE ====================
 TEST(MultisetTest, EraseByKeyRemovesAllMatches) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(5);
     ms.insert(5);
     ms.insert(7);
@@ -75,17 +91,17 @@ TEST(MultisetTest, EraseByKeyRemovesAllMatches) {
 }
 
 TEST(MultisetTest, EraseByIteratorRemovesSingleElement) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(7);
     ms.insert(8);
-    Multiset<int>::iterator it = ms.find(7);
+    MultiSet<int>::iterator it = ms.find(7);
     ms.erase(it);
     EXPECT_EQ(ms.count(7), 0);
 }
 
 ///==================== SIZE AND EMPTY ====================
 TEST(MultisetTest, SizeAndEmptyWorkCorrectly) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(1);
     ms.insert(2);
     EXPECT_EQ(ms.empty(), false);
@@ -97,10 +113,10 @@ TEST(MultisetTest, SizeAndEmptyWorkCorrectly) {
 
 ///==================== COPY CONSTRUCTOR ====================
 TEST(MultisetTest, CopyConstructorCreatesEqualSet) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(1);
     ms.insert(2);
-    Multiset<int> copy(ms);
+    MultiSet<int> copy(ms);
     EXPECT_EQ(copy == ms, true);
     copy.insert(3);
     EXPECT_EQ(copy == ms, false);
@@ -108,10 +124,10 @@ TEST(MultisetTest, CopyConstructorCreatesEqualSet) {
 
 ///==================== ASSIGNMENT OPERATOR ====================
 TEST(MultisetTest, AssignmentOperatorCopiesCorrectly) {
-    Multiset<int> a;
+    MultiSet<int> a;
     a.insert(1);
     a.insert(2);
-    Multiset<int> b;
+    MultiSet<int> b;
     b = a;
     EXPECT_EQ(b == a, true);
     b.insert(5);
@@ -120,10 +136,10 @@ TEST(MultisetTest, AssignmentOperatorCopiesCorrectly) {
 
 ///==================== COMPARISON OPERATORS ====================
 TEST(MultisetTest, ComparisonOperatorsWorkCorrectly) {
-    Multiset<int> a;
+    MultiSet<int> a;
     a.insert(1);
     a.insert(2);
-    Multiset<int> b;
+    MultiSet<int> b;
     b.insert(1);
     b.insert(3);
     EXPECT_EQ(a < b, true);
@@ -133,11 +149,11 @@ TEST(MultisetTest, ComparisonOperatorsWorkCorrectly) {
 
 ///==================== ITERATOR TRAVERSAL ====================
 TEST(MultisetTest, IteratorTraversalInOrder) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(3);
     ms.insert(1);
     ms.insert(2);
-    Multiset<int>::iterator it = ms.begin();
+    MultiSet<int>::iterator it = ms.begin();
     int prev = *it;
     ++it;
     while (it != ms.end()) {
@@ -147,9 +163,38 @@ TEST(MultisetTest, IteratorTraversalInOrder) {
     }
 }
 
+TEST(MultisetTest, VisitorsMatchRecursiveTraversals) {
+    MultiSet<int> ms;
+    for (int i = 1; i <= 7; ++i) { ms.insert(i); }
+    for (int i = 0; i < 50; ++i) { ms.insert((i * 37) % 23); }
+    std::ostringstream visited;
+    std::ostringstream expected;
+    ms.visit_preorder([&visited](const int& x) { visited << x << ' '; });
+    ms.preOrderRec(expected);
+    EXPECT_EQ(visited.str(), expected.str());
+    visited.str("");
+    expected.str("");
+    ms.visit_inorder([&visited](const int& x) { visited << x << ' '; });
+    ms.inOrderRec(expected);
+    EXPECT_EQ(visited.str(), expected.str());
+    visited.str("");
+    expected.str("");
+    ms.visit_postorder([&visited](const int& x) { visited << x << ' '; });
+    ms.postOrderRec(expected);
+    EXPECT_EQ(visited.str(), expected.str());
+
+    MultiSet<int> perfect;
+    for (int i = 1; i <= 7; ++i) { perfect.insert(i); }
+    std::vector<int> levels;
+    perfect.visit_levelorder([&levels](const int& x) { levels.push_back(x); });
+    const int expectedLevels[] = { 4, 2, 6, 1, 3, 5, 7 };
+    EXPECT_EQ(levels, std::vector<int>(expectedLevels, expectedLevels + 7));
+    MultiSet<int>().visit_levelorder([](const int&) { ADD_FAILURE(); });
+}
+
 ///==================== CLEAR ====================
 TEST(MultisetTest, ClearRemovesAll) {
-    Multiset<int> ms;
+    MultiSet<int> ms;
     ms.insert(1);
     ms.insert(2);
     ms.clear();
@@ -159,16 +204,859 @@ TEST(MultisetTest, ClearRemovesAll) {
 
 ///==================== SWAP ====================
 TEST(MultisetTest, SwapExchangesContents) {
-    Multiset<int> a;
+    MultiSet<int> a;
     a.insert(1);
     a.insert(2);
-    Multiset<int> b;
+    MultiSet<int> b;
     b.insert(100);
     a.swap(b);
     EXPECT_EQ(a.count(100), 1);
     EXPECT_EQ(b.count(1), 1);
 }
 
+///==================== PARALLEL ====================
+TEST(MultisetTest, ParallelReduceMatchesSequentialScan) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 1000; ++i) {
+        ms.insert((i * 7919) % 1000);
+    }
+    long long sequential = 0;
+    for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) {
+        sequential += *it;
+    }
+    EXPECT_EQ(ms.parallel_reduce(0LL, std::plus<long long>(), 4), sequential);
+
+    MultiSet<std::string> words;
+    words.insert("c");
+    words.insert("a");
+    words.insert("b");
+    words.insert("a");
+    EXPECT_EQ(words.parallel_reduce(std::string(), std::plus<std::string>(), 3), "aabc");
+
+    MultiSet<int> many;
+    long long squares = 0;
+    for (int i = 0; i < 100000; ++i) {
+        many.insert(i % 5000);
+        squares += static_cast<long long>(i % 5000) * (i % 5000);
+    }
+    const auto count = [](long a, int) { return a + 1; };
+    EXPECT_EQ(many.parallel_reduce(0L, count, std::plus<long>(), 4), 100000L);
+    const auto addSquare = [](long long a, int x) { return a + static_cast<long long>(x) * x; };
+    EXPECT_EQ(many.parallel_reduce(0LL, addSquare, std::plus<long long>(), 4), squares);
+}
+
+TEST(MultisetTest, ParallelForEachVisitsEveryElement) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 500; ++i) {
+        ms.insert(i % 50);
+    }
+    std::atomic<long> visited(0);
+    ms.parallel_for_each([&visited](const int&) { ++visited; }, 4);
+    EXPECT_EQ(visited.load(), 500);
+}
+
+///==================== SERIALIZATION ====================
+TEST(MultisetTest, SaveLoadRoundTrip) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 100; ++i) {
+        ms.insert(i % 10);
+    }
+    std::stringstream stream;
+    EXPECT_EQ(ms.save(stream), true);
+    MultiSet<int> loaded;
+    loaded.insert(42);
+    EXPECT_EQ(loaded.load(stream), true);
+    EXPECT_EQ(loaded == ms, true);
+    EXPECT_EQ(loaded.count(3), 10u);
+
+    MultiSet<std::string> words;
+    words.insert("beta");
+    words.insert("alpha");
+    words.insert("");
+    std::stringstream wordStream;
+    EXPECT_EQ(words.save(wordStream), true);
+    MultiSet<std::string> loadedWords;
+    EXPECT_EQ(loadedWords.load(wordStream), true);
+    EXPECT_EQ(loadedWords == words, true);
+}
+
+TEST(MultisetTest, LoadRejectsTruncatedInput) {
+    MultiSet<int> ms;
+    ms.insert(1);
+    ms.insert(2);
+    std::stringstream stream;
+    ms.save(stream);
+    const std::string bytes = stream.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    MultiSet<int> loaded;
+    EXPECT_EQ(loaded.load(truncated), false);
+    EXPECT_EQ(loaded.empty(), true);
+}
+
+/// Key whose decoding throws once budget reads have been made.
+struct FragileKey {
+    int value;
+    bool operator<(const FragileKey& rhv) const { return value < rhv.value; }
+    bool operator>(const FragileKey& rhv) const { return value > rhv.value; }
+    bool operator<=(const FragileKey& rhv) const { return value <= rhv.value; }
+    bool operator>=(const FragileKey& rhv) const { return value >= rhv.value; }
+    bool operator==(const FragileKey& rhv) const { return value == rhv.value; }
+    bool operator!=(const FragileKey& rhv) const { return value != rhv.value; }
+    static int budget;
+};
+
+int FragileKey::budget = 0;
+
+template <>
+struct MultiSetSerializer<FragileKey>
+{
+    static uint32_t elementSize() { return sizeof(int); }
+    static void write(MultiSetWriter& out, const FragileKey& key) { out.writeValue(key.value); }
+    static FragileKey read(MultiSetReader& in)
+    {
+        if (0 == FragileKey::budget--) { throw std::runtime_error("fragile key"); }
+        const FragileKey key = { in.readValue<int>() };
+        return key;
+    }
+};
+
+TEST(MultisetTest, LoadUsesNodeStorageAndCleansUp) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 1000; ++i) {
+        ms.insert(i);
+    }
+    std::stringstream stream;
+    ms.save(stream);
+    MultiSet<int> pooled;
+    pooled.set_node_storage(MultiSet<int>::ARENA_STORAGE);
+    EXPECT_TRUE(pooled.load(stream));
+    EXPECT_EQ(pooled.memory_stats().allocatorSlackBytes, 0u);
+    EXPECT_TRUE(pooled == ms);
+
+    typedef MultiSet<FragileKey> FragileSet;
+    FragileSet keys;
+    for (int i = 0; i < 100; ++i) {
+        const FragileKey key = { i };
+        keys.insert(key);
+    }
+    std::stringstream keyStream;
+    keys.save(keyStream);
+    const size_t before = FragileSet::live_nodes();
+    FragileSet loaded;
+    FragileKey::budget = 70;
+    EXPECT_THROW(loaded.load(keyStream), std::runtime_error);
+    EXPECT_EQ(FragileSet::live_nodes(), before);
+    EXPECT_TRUE(loaded.empty());
+}
+
+///==================== PERSISTENT ====================
+TEST(MultisetTest, PersistentSetSurvivesReopen) {
+    const char* path = "utest_persistent_multiset.dat";
+    std::remove(path);
+    {
+        PersistentMultiSet<int, uint32_t> ms(path);
+        EXPECT_EQ(ms.is_open(), true);
+        for (int i = 0; i < 3000; ++i) {
+            ms.insert(i % 100);
+        }
+        EXPECT_EQ(ms.erase(7), 30u);
+        EXPECT_EQ(ms.sync(), true);
+    }
+    PersistentMultiSet<int, uint32_t> reopened(path, true);
+    EXPECT_EQ(reopened.is_open(), true);
+    EXPECT_EQ(reopened.size(), 2970u);
+    EXPECT_EQ(reopened.count(7), 0u);
+    EXPECT_EQ(reopened.count(8), 30u);
+    EXPECT_EQ(*reopened.lower_bound(7), 8);
+    int prev = *reopened.begin();
+    for (PersistentMultiSet<int, uint32_t>::const_iterator it = reopened.begin(); it != reopened.end(); ++it) {
+        EXPECT_EQ(*it >= prev, true);
+        prev = *it;
+    }
+    reopened.close();
+    std::remove(path);
+}
+
+TEST(MultisetTest, PersistentSetRejectsOtherOffsetWidth) {
+    const char* path = "utest_persistent_multiset_width.dat";
+    std::remove(path);
+    {
+        PersistentMultiSet<int, uint32_t> ms(path);
+        ms.insert(1);
+    }
+    PersistentMultiSet<int, uint64_t> wide(path, true);
+    EXPECT_EQ(wide.is_open(), false);
+    std::remove(path);
+}
+
+TEST(MultisetTest, PersistentSetRejectsCorruptFreeList) {
+    const char* path = "utest_persistent_multiset_free.dat";
+    std::remove(path);
+    {
+        PersistentMultiSet<int, uint32_t> ms(path);
+        ms.insert(1);
+        ms.insert(2);
+        ms.erase(1);
+    }
+    /// freeList_ is the last header field, 56 bytes into the file.
+    std::FILE* file = std::fopen(path, "r+b");
+    ASSERT_NE(file, static_cast<std::FILE*>(NULL));
+    const uint64_t farAway = 1u << 30;
+    EXPECT_EQ(std::fseek(file, 56, SEEK_SET), 0);
+    EXPECT_EQ(std::fwrite(&farAway, sizeof(farAway), 1, file), 1u);
+    std::fclose(file);
+    PersistentMultiSet<int, uint32_t> corrupt(path, true);
+    EXPECT_EQ(corrupt.is_open(), false);
+    std::remove(path);
+}
+
+///==================== MEMORY STATS ====================
+TEST(MultisetTest, MemoryStatsAccountForEveryNode) {
+    MultiSet<int> ms;
+    EXPECT_EQ(ms.memory_stats().nodeCount, 0u);
+    EXPECT_EQ(ms.memory_stats().height, 0);
+    for (int i = 0; i < 64; ++i) {
+        ms.insert(i);
+    }
+    const MultiSet<int>::MemoryStats stats = ms.memory_stats();
+    EXPECT_EQ(stats.nodeCount, 64u);
+    EXPECT_EQ(stats.payloadBytes, 64 * sizeof(int));
+    EXPECT_EQ(stats.pointerBytes, 64 * 3 * sizeof(void*));
+    EXPECT_EQ(stats.metadataBytes, 64 * sizeof(AvlBalance::Info));
+    EXPECT_EQ(stats.payloadBytes + stats.pointerBytes + stats.metadataBytes + stats.paddingBytes
+              + stats.allocatorSlackBytes + sizeof(ms), stats.totalBytes);
+    EXPECT_EQ(stats.height >= 7 && stats.height <= 9, true);
+
+    MultiSet<int, NoInstrumentation, WeightBalance, SumAugment<int> > weighted;
+    for (int i = 0; i < 64; ++i) {
+        weighted.insert(i);
+    }
+    const MultiSet<int, NoInstrumentation, WeightBalance, SumAugment<int> >::MemoryStats weightedStats
+        = weighted.memory_stats();
+    EXPECT_EQ(weightedStats.metadataBytes, 64 * (sizeof(std::size_t) + sizeof(int)));
+    EXPECT_LT(weightedStats.paddingBytes, 64 * sizeof(void*));
+
+    MultiSet<int, NoInstrumentation, WeightBalance> plain;
+    for (int i = 0; i < 64; ++i) {
+        plain.insert(i);
+    }
+    /// The lazy-erase mark lives in the balance info and takes no room.
+    EXPECT_LT(plain.memory_stats().paddingBytes, 64 * sizeof(void*));
+}
+
+TEST(MultisetTest, LiveBytesFollowAllocations) {
+    const size_t before = MultiSet<double>::live_nodes();
+    const size_t beforeBytes = MultiSet<double>::live_bytes();
+    {
+        MultiSet<double> ms;
+        ms.insert(1.0);
+        ms.insert(2.0);
+        EXPECT_EQ(MultiSet<double>::live_nodes(), before + 2);
+        EXPECT_EQ(MultiSet<double>::live_bytes() > beforeBytes, true);
+    }
+    EXPECT_EQ(MultiSet<double>::live_nodes(), before);
+    EXPECT_EQ(MultiSet<double>::live_bytes(), beforeBytes);
+}
+
+///==================== INSTRUMENTATION ====================
+static void
+countSample(MultiSetOperation operation, uint64_t, void* context)
+{
+    if (MULTISET_FIND == operation) { ++*static_cast<int*>(context); }
+}
+
+TEST(MultisetTest, InstrumentationCountsOperations) {
+    EXPECT_EQ(sizeof(MultiSet<int>), 4 * sizeof(void*) + 3 * sizeof(std::size_t));
+    MultiSet<int, CountingInstrumentation> ms;
+    for (int i = 0; i < 100; ++i) {
+        ms.insert(i);
+    }
+    const MultiSetCounters& counters = ms.instrumentation().counters();
+    EXPECT_EQ(counters.allocations, 100u);
+    EXPECT_EQ(counters.rotations > 0, true);
+    EXPECT_EQ(counters.retraceSteps > 0, true);
+    ms.instrumentation().resetCounters();
+    ms.find(42);
+    EXPECT_EQ(counters.comparisons > 0, true);
+    EXPECT_EQ(counters.comparisons < 30, true);
+    ms.erase(42);
+    EXPECT_EQ(counters.frees, 1u);
+
+    int samples = 0;
+    ms.instrumentation().setLatencySampler(countSample, &samples, 2);
+    for (int i = 0; i < 10; ++i) {
+        ms.find(i);
+    }
+    EXPECT_EQ(samples, 5);
+}
+
+///==================== FREEZE ====================
+TEST(MultisetTest, FrozenSetMatchesSource) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 200; ++i) {
+        ms.insert((i * 37) % 50);
+    }
+    const FrozenMultiSet<int> frozen = ms.freeze();
+    EXPECT_EQ(frozen.size(), 200u);
+    for (int k = -1; k <= 51; ++k) {
+        EXPECT_EQ(frozen.count(k), ms.count(k));
+        EXPECT_EQ(frozen.lower_bound(k) == frozen.end(), ms.lower_bound(k) == ms.end());
+        EXPECT_EQ(frozen.find(k) == frozen.end(), ms.find(k) == ms.end());
+    }
+    EXPECT_EQ(*frozen.upper_bound(10), 11);
+    MultiSet<int>::const_iterator source = ms.begin();
+    for (FrozenMultiSet<int>::const_iterator it = frozen.begin(); it != frozen.end(); ++it, ++source) {
+        EXPECT_EQ(*it, *source);
+    }
+}
+
+///==================== BALANCE POLICIES ====================
+template <typename Balance>
+static void
+checkBalancePolicy(int maxHeight)
+{
+    MultiSet<int, NoInstrumentation, Balance> ms;
+    for (int i = 0; i < 1024; ++i) {
+        ms.insert(i);
+    }
+    for (int i = 0; i < 1024; i += 3) {
+        ms.erase(ms.find(i));
+    }
+    ms.insert(ms.end(), 2000);
+    ms.insert(ms.begin(), 1);
+    EXPECT_EQ(ms.size(), 684u);
+    EXPECT_LE(ms.memory_stats().height, maxHeight);
+    EXPECT_TRUE(ms.is_balanced());
+    int previous = -1;
+    for (typename MultiSet<int, NoInstrumentation, Balance>::const_iterator it = ms.begin(); it != ms.end(); ++it) {
+        EXPECT_LE(previous, *it);
+        EXPECT_NE(*it % 3 == 0 && *it < 1024, true);
+        previous = *it;
+    }
+    EXPECT_EQ(ms.count(1), 2);
+
+    std::srand(maxHeight);
+    for (int i = 1; i <= 4000; ++i) {
+        const int key = std::rand() % 512;
+        if (std::rand() % 3 != 0) {
+            ms.insert(key);
+        } else if (ms.find(key) != ms.end()) {
+            ms.erase(ms.find(key));
+        }
+        if (0 == i % 500) { EXPECT_TRUE(ms.is_balanced()); }
+    }
+    while (!ms.empty()) {
+        ms.erase(ms.begin());
+        EXPECT_TRUE(ms.is_balanced());
+    }
+}
+
+TEST(MultisetTest, BalancePoliciesKeepOrderAndHeight) {
+    checkBalancePolicy<AvlBalance>(14);
+    checkBalancePolicy<RedBlackBalance>(20);
+    checkBalancePolicy<WeightBalance>(20);
+}
+
+///==================== RANGE AGGREGATE ====================
+TEST(MultisetTest, RangeAggregateMatchesScan) {
+    typedef MultiSet<int, NoInstrumentation, AvlBalance, SumAugment<long> > SumSet;
+    SumSet sums;
+    MultiSet<int, NoInstrumentation, RedBlackBalance, MaxAugment<int> > maxima;
+    for (int i = 0; i < 300; ++i) {
+        sums.insert((i * 17) % 101);
+        maxima.insert((i * 17) % 101);
+    }
+    sums.erase(50);
+    maxima.erase(50);
+    for (int lo = -5; lo < 110; lo += 7) {
+        for (int hi = lo; hi < 110; hi += 11) {
+            long sum = 0;
+            int maximum = std::numeric_limits<int>::lowest();
+            for (SumSet::const_iterator it = sums.lower_bound(lo); it != sums.upper_bound(hi); ++it) {
+                sum += *it;
+                maximum = std::max(maximum, *it);
+            }
+            EXPECT_EQ(sums.range_aggregate(lo, hi), sum);
+            EXPECT_EQ(maxima.range_aggregate(lo, hi), maximum);
+        }
+    }
+    EXPECT_EQ(sums.range_aggregate(60, 40), 0);
+}
+
+///==================== SIMD SEARCH ====================
+TEST(MultisetTest, BlockSetMatchesSortedArray) {
+    std::vector<double> sorted;
+    for (int i = 0; i < 1000; ++i) {
+        sorted.push_back((i * 7) / 10);
+    }
+    const FrozenBlockMultiSet<double> block(sorted.begin(), sorted.size());
+    EXPECT_EQ(block.size(), 1000u);
+    std::vector<double> keys;
+    for (int k = -2; k <= 702; ++k) {
+        keys.push_back(k);
+        keys.push_back(k + 0.5);
+    }
+    std::vector<size_t> positions(keys.size());
+    std::vector<size_t> counts(keys.size());
+    block.lower_bound_batch(&keys[0], keys.size(), &positions[0]);
+    block.count_batch(&keys[0], keys.size(), &counts[0]);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const size_t lower = std::lower_bound(sorted.begin(), sorted.end(), keys[i]) - sorted.begin();
+        const size_t upper = std::upper_bound(sorted.begin(), sorted.end(), keys[i]) - sorted.begin();
+        EXPECT_EQ(size_t(block.lower_bound(keys[i]) - block.begin()), lower);
+        EXPECT_EQ(size_t(block.upper_bound(keys[i]) - block.begin()), upper);
+        EXPECT_EQ(block.count(keys[i]), upper - lower);
+        EXPECT_EQ(positions[i], lower);
+        EXPECT_EQ(counts[i], upper - lower);
+    }
+    const FrozenBlockMultiSet<int> empty;
+    EXPECT_TRUE(empty.find(1) == empty.end());
+}
+
+///==================== COMPACT ====================
+TEST(MultisetTest, CompactSetMatchesMultiSet) {
+    MultiSet<int> ms;
+    CompactMultiSet<int> compact;
+    for (int i = 0; i < 500; ++i) {
+        ms.insert((i * 31) % 97);
+        compact.insert((i * 31) % 97);
+    }
+    for (int k = 0; k < 97; k += 3) {
+        EXPECT_EQ(compact.erase(k), ms.erase(k));
+    }
+    EXPECT_EQ(compact.size(), ms.size());
+    for (int k = -1; k <= 98; ++k) {
+        EXPECT_EQ(compact.count(k), ms.count(k));
+        EXPECT_EQ(compact.find(k) == compact.end(), ms.find(k) == ms.end());
+    }
+    MultiSet<int>::const_iterator source = ms.begin();
+    for (CompactMultiSet<int>::const_iterator it = compact.begin(); it != compact.end(); ++it, ++source) {
+        EXPECT_EQ(*it, *source);
+    }
+    EXPECT_EQ(CompactMultiSet<int>::node_size(), 16u);
+    EXPECT_LE(compact.height(), 12);
+}
+
+///==================== INTRUSIVE ====================
+struct Timer {
+    int deadline;
+    MultiSetHook byDeadline;
+    bool operator<(const Timer& rhv) const { return deadline < rhv.deadline; }
+};
+
+TEST(MultisetTest, IntrusiveSetLinksCallerObjects) {
+    std::vector<Timer> timers(100);
+    IntrusiveMultiSet<Timer, &Timer::byDeadline> ms;
+    for (int i = 0; i < 100; ++i) {
+        timers[i].deadline = (i * 13) % 40;
+        ms.insert(timers[i]);
+    }
+    EXPECT_EQ(ms.size(), 100u);
+    for (int i = 0; i < 100; i += 2) {
+        ms.unlink(timers[i]);
+        EXPECT_FALSE(timers[i].byDeadline.is_linked());
+    }
+    EXPECT_EQ(ms.size(), 50u);
+    int previous = -1;
+    for (IntrusiveMultiSet<Timer, &Timer::byDeadline>::iterator it = ms.begin(); it != ms.end(); ++it) {
+        EXPECT_LE(previous, it->deadline);
+        EXPECT_EQ((&*it - &timers[0]) % 2, 1);
+        previous = it->deadline;
+    }
+    Timer probe;
+    probe.deadline = 13;
+    EXPECT_EQ(&*ms.find(probe), &timers[1]);
+    const size_t equal = ms.count(probe);
+    EXPECT_GT(equal, 1u);
+    EXPECT_EQ(ms.erase(static_cast<const Timer&>(timers[1])), equal);
+    EXPECT_EQ(ms.size(), 50u - equal);
+    ms.clear();
+    EXPECT_FALSE(timers[1].byDeadline.is_linked());
+}
+
+///==================== LAZY ERASE ====================
+TEST(MultisetTest, LazyEraseSkipsDeadAndCompacts) {
+    MultiSet<int, NoInstrumentation, AvlBalance, SumAugment<long> > ms;
+    for (int i = 0; i < 100; ++i) { ms.insert(i % 25); }
+    ms.set_lazy_erase(true, 60);
+    EXPECT_EQ(ms.erase(3), 4u);
+    ms.erase(ms.find(0));
+    ms.erase(ms.lower_bound(24), ms.end());
+    EXPECT_EQ(ms.dead_count(), 9u);
+    EXPECT_EQ(ms.size(), 91u);
+    EXPECT_EQ(ms.count(0), 3u);
+    EXPECT_EQ(*ms.lower_bound(3), 4);
+    EXPECT_EQ(*ms.rbegin(), 23);
+    EXPECT_EQ(ms.range_aggregate(0, 5), 4 * (1 + 2 + 4 + 5));
+    EXPECT_EQ(ms.parallel_reduce(0L, std::plus<long>(), 4), 4L * 300 - 4 * 3 - 4 * 24);
+    for (int i = 4; i < 20; ++i) { ms.erase(i); }
+    EXPECT_EQ(ms.dead_count(), 12u);
+    EXPECT_EQ(ms.size(), 27u);
+    ms.set_lazy_erase(false);
+    EXPECT_EQ(ms.dead_count(), 0u);
+    ms.erase(ms.begin());
+    EXPECT_EQ(*ms.begin(), 0);
+    EXPECT_EQ(ms.size(), 26u);
+
+    MultiSet<int> single;
+    single.set_lazy_erase(true);
+    single.erase(single.insert(7));
+    EXPECT_TRUE(single.empty());
+    single.insert(8);
+    EXPECT_EQ(*single.begin(), 8);
+    EXPECT_EQ(single.size(), 1u);
+}
+
+///==================== RANGE ITERATION ====================
+TEST(MultisetTest, ForEachInRangeMatchesIterators) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 200; ++i) { ms.insert((i * 31) % 67); }
+    for (int lo = -3; lo < 70; lo += 5) {
+        for (int hi = lo - 2; hi < 72; hi += 9) {
+            std::vector<int> expected;
+            if (lo <= hi) {
+                for (MultiSet<int>::const_iterator it = ms.lower_bound(lo); it != ms.upper_bound(hi); ++it) {
+                    expected.push_back(*it);
+                }
+            }
+            std::vector<int> visited;
+            ms.for_each_in_range(lo, hi, [&visited](const int& x) { visited.push_back(x); });
+            EXPECT_EQ(visited, expected);
+        }
+    }
+}
+
+///==================== NODE HANDLES ====================
+TEST(MultisetTest, ExtractedNodesMoveWithoutReallocation) {
+    const size_t before = MultiSet<long>::live_nodes();
+    MultiSet<long> source;
+    MultiSet<long> target;
+    for (long i = 0; i < 40; ++i) { source.insert(i % 10); }
+    EXPECT_EQ(MultiSet<long>::live_nodes(), before + 40);
+    MultiSet<long>::node_type node = source.extract(source.find(3));
+    EXPECT_FALSE(node.empty());
+    EXPECT_EQ(node.value(), 3);
+    node.value() = 42;
+    EXPECT_EQ(*source.insert(std::move(node)), 42);
+    EXPECT_TRUE(node.empty());
+    for (long i = 0; i < 4; ++i) { target.insert(source.extract(7)); }
+    EXPECT_TRUE(source.extract(7).empty());
+    EXPECT_TRUE(target.insert(MultiSet<long>::node_type()) == target.end());
+    EXPECT_EQ(source.count(3), 3u);
+    EXPECT_EQ(source.count(42), 1u);
+    EXPECT_EQ(source.size(), 36u);
+    EXPECT_EQ(target.count(7), 4u);
+    EXPECT_EQ(MultiSet<long>::live_nodes(), before + 40);
+    {
+        MultiSet<long>::node_type dropped = target.extract(target.begin());
+    }
+    EXPECT_EQ(MultiSet<long>::live_nodes(), before + 39);
+}
+
+///==================== FINGER SEARCH ====================
+TEST(MultisetTest, FingerSearchMatchesRootSearch) {
+    MultiSet<int> ms;
+    for (int i = 0; i < 500; ++i) { ms.insert((i * 7) % 151); }
+    std::vector<MultiSet<int>::const_iterator> hints;
+    for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) { hints.push_back(it); }
+    hints.push_back(ms.end());
+    for (size_t h = 0; h < hints.size(); h += 13) {
+        for (int key = -2; key < 155; key += 3) {
+            EXPECT_TRUE(ms.lower_bound(hints[h], key) == ms.lower_bound(key));
+            EXPECT_TRUE(ms.find(hints[h], key) == ms.find(key));
+        }
+    }
+    MultiSet<int> walked(ms);
+    walked.set_finger_search(true);
+    for (int step = 0, key = 75; step < 300; ++step, key = (key + (step % 5) * 11) % 160 - 2) {
+        EXPECT_TRUE(walked.lower_bound(key) == walked.end() || *walked.lower_bound(key) == *ms.lower_bound(key));
+        EXPECT_EQ(walked.count(key), ms.count(key));
+        if (step % 10 == 0 && ms.count(key) != 0) { walked.erase(walked.find(key)); ms.erase(ms.find(key)); }
+    }
+    EXPECT_TRUE(walked == ms);
+}
+
+///==================== ERASE_IF ====================
+TEST(MultisetTest, EraseIfKeepsSurvivorsBalanced) {
+    typedef MultiSet<int, NoInstrumentation, RedBlackBalance, SumAugment<long> > SumSet;
+    const size_t before = SumSet::live_nodes();
+    SumSet ms;
+    for (int i = 0; i < 1000; ++i) { ms.insert(i % 250); }
+    ms.set_lazy_erase(true);
+    ms.erase(7);
+    EXPECT_EQ(erase_if(ms, [](const int& x) { return x % 3 == 0; }), 4u * 84);
+    EXPECT_EQ(ms.dead_count(), 0u);
+    EXPECT_EQ(ms.size(), 1000u - 4 * 84 - 4);
+    EXPECT_EQ(ms.count(6), 0u);
+    EXPECT_EQ(ms.count(7), 0u);
+    EXPECT_EQ(ms.count(8), 4u);
+    EXPECT_LE(ms.memory_stats().height, 10);
+    EXPECT_EQ(ms.range_aggregate(0, 10), 4 * (1 + 2 + 4 + 5 + 8 + 10));
+    ms.insert(6);
+    EXPECT_EQ(ms.count(6), 1u);
+    EXPECT_EQ(ms.remove_if([](const int&) { return true; }), 661u);
+    EXPECT_TRUE(ms.empty());
+    EXPECT_EQ(SumSet::live_nodes(), before);
+}
+
+///==================== DEFRAGMENT ====================
+TEST(MultisetTest, DefragmentPacksNodesIncrementally) {
+    const size_t before = MultiSet<int>::live_nodes();
+    MultiSet<int> ms;
+    std::vector<int> expected;
+    for (int i = 0; i < 3000; ++i) { ms.insert((i * 53) % 1009); }
+    for (int i = 0; i < 1000; ++i) { ms.erase(ms.find((i * 17) % 1009)); }
+    for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) { expected.push_back(*it); }
+    int calls = 1;
+    while (!ms.defragment(100)) { ++calls; }
+    EXPECT_EQ(calls, 21);
+    std::vector<const int*> addresses;
+    for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) { addresses.push_back(&*it); }
+    EXPECT_EQ(addresses.size(), expected.size());
+    for (size_t i = 2; i < addresses.size(); ++i) {
+        EXPECT_EQ(addresses[i] - addresses[i - 1], addresses[1] - addresses[0]);
+    }
+    EXPECT_EQ(ms.memory_stats().allocatorSlackBytes, 0u);
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before + expected.size());
+
+    EXPECT_TRUE(ms.defragment(std::numeric_limits<size_t>::max(), MultiSet<int>::VEB_LAYOUT));
+    EXPECT_LE(ms.memory_stats().height, 11);
+    ms.insert(5000);
+    ms.erase(ms.find(expected[7]));
+    expected.erase(expected.begin() + 7);
+    expected.push_back(5000);
+    MultiSet<int>::node_type node = ms.extract(ms.find(expected[0]));
+    ms.insert(std::move(node));
+    std::vector<int> contents;
+    for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) { contents.push_back(*it); }
+    EXPECT_EQ(contents, expected);
+    ms.clear();
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before);
+}
+
+///==================== NODE STORAGE ====================
+TEST(MultisetTest, NodeArenaServesAllocations) {
+    const size_t before = MultiSet<int>::live_nodes();
+    const MultiSet<int>::NodeStorage storages[] = { MultiSet<int>::ARENA_STORAGE, MultiSet<int>::HUGE_PAGE_STORAGE };
+    for (size_t s = 0; s < 2; ++s) {
+        MultiSet<int> ms;
+        EXPECT_STREQ(ms.node_storage_backing(), "heap");
+        ms.set_node_storage(storages[s]);
+        std::vector<int> expected;
+        for (int i = 0; i < 5000; ++i) {
+            ms.insert((i * 37) % 997);
+            expected.push_back((i * 37) % 997);
+        }
+        const std::string backing = ms.node_storage_backing();
+        EXPECT_TRUE("heap" == backing || "hugetlb" == backing || "madvise" == backing);
+        EXPECT_EQ(ms.memory_stats().allocatorSlackBytes, 0u);
+        for (int i = 0; i < 2000; ++i) {
+            ms.erase(ms.find((i * 11) % 997));
+            expected.erase(std::find(expected.begin(), expected.end(), (i * 11) % 997));
+        }
+        MultiSet<int>::node_type node = ms.extract(ms.find(5));
+        ms.insert(std::move(node));
+        ms.defragment(1000);
+        for (int i = 0; i < 1000; ++i) {
+            ms.insert(i);
+            expected.push_back(i);
+        }
+        std::sort(expected.begin(), expected.end());
+        std::vector<int> contents;
+        for (MultiSet<int>::const_iterator it = ms.begin(); it != ms.end(); ++it) { contents.push_back(*it); }
+        EXPECT_EQ(contents, expected);
+        EXPECT_EQ(MultiSet<int>::live_nodes(), before + expected.size());
+        const MultiSet<int> copy(ms);
+        EXPECT_EQ(copy.size(), expected.size());
+        EXPECT_FALSE(ms.set_node_storage(MultiSet<int>::HEAP_STORAGE));
+        ms.set_lazy_erase(true);
+        ms.erase(ms.begin(), ms.end());
+        EXPECT_TRUE(ms.empty());
+        EXPECT_TRUE(ms.set_node_storage(MultiSet<int>::HEAP_STORAGE));
+        EXPECT_EQ(ms.dead_count(), 0u);
+        EXPECT_STREQ(ms.node_storage_backing(), "heap");
+    }
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before);
+}
+
+TEST(MultisetTest, ExtractKeepsArenaNodes) {
+    typedef MultiSet<std::string> StringSet;
+    const size_t before = StringSet::live_nodes();
+    StringSet::node_type outlived;
+    {
+        StringSet ms;
+        ms.set_node_storage(StringSet::ARENA_STORAGE);
+        for (int i = 0; i < 100; ++i) { ms.insert(std::to_string(i)); }
+        const std::string* address = &*ms.find("42");
+        StringSet::node_type node = ms.extract(ms.find("42"));
+        EXPECT_EQ(&node.value(), address);
+        node.value() = "420";
+        EXPECT_EQ(&*ms.insert(std::move(node)), address);
+        EXPECT_TRUE(node.empty());
+
+        StringSet other;
+        other.set_node_storage(StringSet::ARENA_STORAGE);
+        EXPECT_EQ(*other.insert(ms.extract(ms.find("7"))), "7");
+        outlived = ms.extract(ms.find("9"));
+        EXPECT_EQ(StringSet::live_nodes(), before + 100);
+    }
+    EXPECT_EQ(outlived.value(), "9");
+    outlived = StringSet::node_type();
+    EXPECT_EQ(StringSet::live_nodes(), before);
+}
+
+///==================== SMALL SET ====================
+TEST(MultisetTest, SmallSetMovesToTreePastCapacity) {
+    const size_t before = MultiSet<int>::live_nodes();
+    SmallMultiSet<int, 4> ms;
+    const int keys[] = { 5, 1, 5, 3 };
+    for (int key : keys) { ms.insert(key); }
+    EXPECT_TRUE(ms.is_inline());
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before);
+    EXPECT_EQ(ms.count(5), 2u);
+    EXPECT_EQ(*ms.lower_bound(2), 3);
+    EXPECT_TRUE(ms.find(4) == ms.end());
+    EXPECT_EQ(*--ms.end(), 5);
+
+    const SmallMultiSet<int, 4> small(ms);
+    ms.insert(2);
+    EXPECT_FALSE(ms.is_inline());
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before + 5);
+    std::vector<int> contents;
+    for (SmallMultiSet<int, 4>::const_iterator it = ms.begin(); it != ms.end(); ++it) { contents.push_back(*it); }
+    EXPECT_EQ(contents, std::vector<int>({ 1, 2, 3, 5, 5 }));
+    EXPECT_EQ(*--ms.end(), 5);
+    EXPECT_EQ(ms.erase(5), 2u);
+    ms.erase(ms.find(1));
+    EXPECT_EQ(ms.size(), 2u);
+
+    SmallMultiSet<int, 4> copy(small);
+    copy.swap(ms);
+    EXPECT_TRUE(ms.is_inline());
+    EXPECT_EQ(ms.size(), 4u);
+    EXPECT_EQ(copy.size(), 2u);
+    copy.clear();
+    EXPECT_TRUE(copy.is_inline());
+    EXPECT_EQ(MultiSet<int>::live_nodes(), before);
+
+    SmallMultiSet<std::string, 2> words;
+    words.insert("a long enough string to live on the heap");
+    words.insert("b");
+    words.insert(*words.begin());
+    EXPECT_FALSE(words.is_inline());
+    EXPECT_EQ(words.count("a long enough string to live on the heap"), 2u);
+}
+
+///==================== STATIC SET ====================
+constexpr StaticMultiSet<int, 8> STATIC_TABLE{ 7, 2, 7, -3, 5 };
+static_assert(STATIC_TABLE.size() == 5, "built at compile time");
+static_assert(*STATIC_TABLE.begin() == -3 && STATIC_TABLE.count(7) == 2, "sorted at compile time");
+static_assert(STATIC_TABLE.find(4) == STATIC_TABLE.end(), "looked up at compile time");
+
+TEST(MultisetTest, StaticSetMatchesSortedArray) {
+    std::vector<int> contents(STATIC_TABLE.begin(), STATIC_TABLE.end());
+    EXPECT_EQ(contents, std::vector<int>({ -3, 2, 5, 7, 7 }));
+    EXPECT_EQ(*STATIC_TABLE.lower_bound(3), 5);
+    EXPECT_TRUE(STATIC_TABLE.upper_bound(7) == STATIC_TABLE.end());
+
+    StaticMultiSet<int, 8> ms(STATIC_TABLE);
+    EXPECT_EQ(*ms.insert(3), 3);
+    EXPECT_EQ(*ms.insert(7), 7);
+    EXPECT_EQ(*ms.insert(0), 0);
+    EXPECT_TRUE(ms.insert(1) == ms.end());
+    EXPECT_EQ(ms.size(), ms.max_size());
+    EXPECT_EQ(ms.erase(7), 3u);
+    ms.erase(ms.find(-3));
+    contents.assign(ms.begin(), ms.end());
+    EXPECT_EQ(contents, std::vector<int>({ 0, 2, 3, 5 }));
+    ms.clear();
+    EXPECT_TRUE(ms.empty());
+}
+
+///==================== LATENCY HISTOGRAM ====================
+TEST(MultisetTest, LatencyHistogramPercentilesWithinOnePercent) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0u);
+    for (uint64_t value = 1; value <= 100000; ++value) { histogram.record(value * 37); }
+    EXPECT_EQ(histogram.count(), 100000u);
+    EXPECT_EQ(histogram.min(), 37u);
+    EXPECT_EQ(histogram.max(), 3700000u);
+    const double percents[] = { 1, 50, 99, 99.9 };
+    for (double percent : percents) {
+        const double expected = percent * 1000 * 37;
+        EXPECT_GE(static_cast<double>(histogram.percentile(percent)), expected);
+        EXPECT_LE(static_cast<double>(histogram.percentile(percent)), expected * 1.01);
+    }
+    EXPECT_EQ(histogram.percentile(100), histogram.max());
+
+    LatencyHistogram other;
+    other.record(5);
+    other.record(1ULL << 40);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.min(), 5u);
+    EXPECT_EQ(histogram.max(), 1ULL << 40);
+    EXPECT_EQ(histogram.percentile(0), 5u);
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+}
+
+///==================== OPERATION TRACE ====================
+TEST(MultisetTest, TraceRecordsOutermostOperations) {
+    typedef MultiSet<int, TracingInstrumentation<int> > TracedSet;
+    std::stringstream trace;
+    TracedSet ms;
+    ms.insert(1);
+    {
+        MultiSetTraceRecorder<int> recorder(trace);
+        ms.instrumentation().setTraceRecorder(&recorder);
+        ms.insert(5);
+        ms.insert(ms.end(), 3);
+        EXPECT_EQ(ms.count(5), 1u);
+        ms.erase(ms.find(3));
+        ms.erase(7);
+        ms.for_each_in_range(0, 9, [](const int&) {});
+        ms.remove_if([](const int& x) { return x > 4; });
+        ms.erase(ms.begin(), ms.end());
+        const TracedSet copy(ms);
+        EXPECT_EQ(copy.instrumentation().traceRecorder(), static_cast<MultiSetTraceRecorder<int>*>(NULL));
+        copy.find(1);
+        ms.instrumentation().setTraceRecorder(NULL);
+        ms.find(1);
+        EXPECT_EQ(recorder.operation_count(), 8u);
+    }
+    EXPECT_EQ(trace.str().size(), 16u + 8 * 5 + 4);
+
+    MultiSetTraceReader<int> reader(trace);
+    const MultiSetTraceOperation operations[] = {
+        MULTISET_TRACE_INSERT, MULTISET_TRACE_INSERT, MULTISET_TRACE_COUNT, MULTISET_TRACE_FIND,
+        MULTISET_TRACE_ERASE, MULTISET_TRACE_ERASE_ALL, MULTISET_TRACE_RANGE_SCAN, MULTISET_TRACE_ERASE
+    };
+    const int keys[] = { 5, 3, 5, 3, 3, 7, 0, 1 };
+    MultiSetTraceOperation operation;
+    int key = 0;
+    int hi = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(reader.next(operation, key, hi));
+        EXPECT_EQ(operation, operations[i]);
+        EXPECT_EQ(key, keys[i]);
+    }
+    EXPECT_EQ(hi, 9);
+    EXPECT_FALSE(reader.next(operation, key, hi));
+    EXPECT_TRUE(reader.good());
+
+    std::stringstream sameSize(trace.str());
+    MultiSetTraceReader<float> floats(sameSize);
+    EXPECT_FALSE(floats.good());
+
+    std::stringstream truncated(trace.str().substr(0, 18));
+    MultiSetTraceReader<int> partial(truncated);
+    EXPECT_FALSE(partial.next(operation, key, hi));
+    EXPECT_FALSE(partial.good());
+    std::stringstream wrongKey(trace.str());
+    MultiSetTraceReader<std::string> mismatched(wrongKey);
+    EXPECT_FALSE(mismatched.good());
+}
+
 int
 main(int argc, char** argv)
 {
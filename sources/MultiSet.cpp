@@ -0,0 +1,7 @@
+#include "headers/MultiSetInstantiation.hpp"
+
+MULTISET_INSTANTIATE(template, int)
+MULTISET_INSTANTIATE(template, long)
+MULTISET_INSTANTIATE(template, double)
+MULTISET_INSTANTIATE(template, std::string)
+
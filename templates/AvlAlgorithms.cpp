@@ -0,0 +1,211 @@
+#include "headers/AvlAlgorithms.hpp"
+#include <algorithm>
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::leftMost(const NodeTraits& t, node_ptr n)
+{
+    if (t.null() == n) { return n; }
+    while (t.left(n) != t.null()) { n = t.left(n); }
+    return n;
+}
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::rightMost(const NodeTraits& t, node_ptr n)
+{
+    if (t.null() == n) { return n; }
+    while (t.right(n) != t.null()) { n = t.right(n); }
+    return n;
+}
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::next(const NodeTraits& t, node_ptr n)
+{
+    if (t.right(n) != t.null()) { return leftMost(t, t.right(n)); }
+    node_ptr p = t.parent(n);
+    while (p != t.null() && t.right(p) == n) {
+        n = p;
+        p = t.parent(p);
+    }
+    return p;
+}
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::prev(const NodeTraits& t, node_ptr n)
+{
+    if (t.left(n) != t.null()) { return rightMost(t, t.left(n)); }
+    node_ptr p = t.parent(n);
+    while (p != t.null() && t.left(p) == n) {
+        n = p;
+        p = t.parent(p);
+    }
+    return p;
+}
+
+/// Follows the heavier side, so this costs O(log n) instead of a full scan.
+template <typename NodeTraits>
+int
+AvlAlgorithms<NodeTraits>::height(const NodeTraits& t, node_ptr root)
+{
+    int result = 0;
+    while (root != t.null()) {
+        ++result;
+        root = t.balance(root) > 0 ? t.right(root) : t.left(root);
+    }
+    return result;
+}
+
+template <typename NodeTraits>
+void
+AvlAlgorithms<NodeTraits>::insert(const NodeTraits& t, node_ptr& root, node_ptr parent, bool isLeft, node_ptr n)
+{
+    t.setParent(n, parent);
+    t.setLeft(n, t.null());
+    t.setRight(n, t.null());
+    t.setBalance(n, 0);
+    if (t.null() == parent) { root = n; return; }
+    isLeft ? t.setLeft(parent, n) : t.setRight(parent, n);
+
+    node_ptr child = n;
+    while (parent != t.null()) {
+        const int factor = t.balance(parent) + (t.left(parent) == child ? -1 : 1);
+        if (2 == factor || -2 == factor) {
+            bool heightDecreased;
+            rebalance(t, root, parent, factor, heightDecreased);
+            return;
+        }
+        t.setBalance(parent, factor);
+        if (0 == factor) { return; }
+        child = parent;
+        parent = t.parent(parent);
+    }
+}
+
+template <typename NodeTraits>
+void
+AvlAlgorithms<NodeTraits>::erase(const NodeTraits& t, node_ptr& root, node_ptr n)
+{
+    node_ptr parent;
+    bool isLeft;
+    if (t.left(n) != t.null() && t.right(n) != t.null()) {
+        /// Move the successor into the place of n.
+        const node_ptr successor = leftMost(t, t.right(n));
+        if (successor == t.right(n)) {
+            parent = successor;
+            isLeft = false;
+        } else {
+            parent = t.parent(successor);
+            isLeft = true;
+            const node_ptr successorRight = t.right(successor);
+            t.setLeft(parent, successorRight);
+            if (successorRight != t.null()) { t.setParent(successorRight, parent); }
+            t.setRight(successor, t.right(n));
+            t.setParent(t.right(n), successor);
+        }
+        t.setLeft(successor, t.left(n));
+        t.setParent(t.left(n), successor);
+        t.setBalance(successor, t.balance(n));
+        t.setParent(successor, t.parent(n));
+        replaceChild(t, root, t.parent(n), n, successor);
+    } else {
+        const node_ptr child = t.left(n) != t.null() ? t.left(n) : t.right(n);
+        parent = t.parent(n);
+        isLeft = parent != t.null() && t.left(parent) == n;
+        if (child != t.null()) { t.setParent(child, parent); }
+        replaceChild(t, root, parent, n, child);
+    }
+
+    /// One side of parent became one level lower.
+    while (parent != t.null()) {
+        const int factor = t.balance(parent) + (isLeft ? 1 : -1);
+        if (1 == factor || -1 == factor) { t.setBalance(parent, factor); return; }
+        node_ptr subtree = parent;
+        if (2 == factor || -2 == factor) {
+            bool heightDecreased;
+            subtree = rebalance(t, root, parent, factor, heightDecreased);
+            if (!heightDecreased) { return; }
+        } else {
+            t.setBalance(parent, factor);
+        }
+        parent = t.parent(subtree);
+        if (parent != t.null()) { isLeft = t.left(parent) == subtree; }
+    }
+}
+
+template <typename NodeTraits>
+void
+AvlAlgorithms<NodeTraits>::replaceChild(const NodeTraits& t, node_ptr& root, node_ptr parent, node_ptr oldChild, node_ptr newChild)
+{
+    if (t.null() == parent) { root = newChild; return; }
+    t.left(parent) == oldChild ? t.setLeft(parent, newChild)
+                               : t.setRight(parent, newChild);
+}
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::rotateLeft(const NodeTraits& t, node_ptr& root, node_ptr n)
+{
+    const node_ptr pivot = t.right(n);
+    const node_ptr inner = t.left(pivot);
+    t.setRight(n, inner);
+    if (inner != t.null()) { t.setParent(inner, n); }
+    t.setParent(pivot, t.parent(n));
+    replaceChild(t, root, t.parent(n), n, pivot);
+    t.setLeft(pivot, n);
+    t.setParent(n, pivot);
+    return pivot;
+}
+
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::rotateRight(const NodeTraits& t, node_ptr& root, node_ptr n)
+{
+    const node_ptr pivot = t.left(n);
+    const node_ptr inner = t.right(pivot);
+    t.setLeft(n, inner);
+    if (inner != t.null()) { t.setParent(inner, n); }
+    t.setParent(pivot, t.parent(n));
+    replaceChild(t, root, t.parent(n), n, pivot);
+    t.setRight(pivot, n);
+    t.setParent(n, pivot);
+    return pivot;
+}
+
+/// n has a balance of -2 or 2, passed as factor: it is never stored, so the
+/// traits only have to represent -1, 0 and 1. Returns the new root of the
+/// subtree and reports whether the subtree got lower than it was before the
+/// rotation.
+template <typename NodeTraits>
+typename AvlAlgorithms<NodeTraits>::node_ptr
+AvlAlgorithms<NodeTraits>::rebalance(const NodeTraits& t, node_ptr& root, node_ptr n, int factor, bool& heightDecreased)
+{
+    const int direction = factor > 0 ? 1 : -1;
+    const node_ptr child = direction > 0 ? t.right(n) : t.left(n);
+    const int childFactor = t.balance(child);
+    if (childFactor != -direction) {
+        direction > 0 ? rotateLeft(t, root, n) : rotateRight(t, root, n);
+        if (0 == childFactor) {
+            t.setBalance(n, direction);
+            t.setBalance(child, -direction);
+            heightDecreased = false;
+        } else {
+            t.setBalance(n, 0);
+            t.setBalance(child, 0);
+            heightDecreased = true;
+        }
+        return child;
+    }
+    const node_ptr grandChild = direction > 0 ? t.left(child) : t.right(child);
+    const int grandFactor = t.balance(grandChild);
+    direction > 0 ? rotateRight(t, root, child) : rotateLeft(t, root, child);
+    direction > 0 ? rotateLeft(t, root, n) : rotateRight(t, root, n);
+    t.setBalance(n, grandFactor == direction ? -direction : 0);
+    t.setBalance(child, grandFactor == -direction ? direction : 0);
+    t.setBalance(grandChild, 0);
+    heightDecreased = true;
+    return grandChild;
+}
+
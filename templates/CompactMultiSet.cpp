@@ -0,0 +1,320 @@
+#include "headers/CompactMultiSet.hpp"
+#include <cassert>
+
+template <typename Data>
+const uint32_t CompactMultiSet<Data>::LINK_MASK;
+
+template <typename Data>
+const typename CompactMultiSet<Data>::size_type CompactMultiSet<Data>::MAX_SIZE;
+
+template <typename Data>
+CompactMultiSet<Data>::CompactMultiSet()
+    : nodes_(1), root_(0), freeList_(0), size_(0)
+{}
+
+template <typename Data>
+template <typename InputIterator>
+CompactMultiSet<Data>::CompactMultiSet(InputIterator first, InputIterator last)
+    : nodes_(1), root_(0), freeList_(0), size_(0)
+{
+    for (; first != last; ++first) { insert(*first); }
+}
+
+template <typename Data>
+void
+CompactMultiSet<Data>::swap(CompactMultiSet& rhv)
+{
+    nodes_.swap(rhv.nodes_);
+    std::swap(root_, rhv.root_);
+    std::swap(freeList_, rhv.freeList_);
+    std::swap(size_, rhv.size_);
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::size() const
+{
+    return size_;
+}
+
+template <typename Data>
+bool
+CompactMultiSet<Data>::empty() const
+{
+    return 0 == size_;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::max_size() const
+{
+    return MAX_SIZE;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::capacity() const
+{
+    return nodes_.capacity() - 1;
+}
+
+/// Reserving up front avoids the pool copies while the set grows.
+template <typename Data>
+void
+CompactMultiSet<Data>::reserve(size_type count)
+{
+    nodes_.reserve(count + 1);
+}
+
+/// Drops all elements, the pool keeps its capacity.
+template <typename Data>
+void
+CompactMultiSet<Data>::clear()
+{
+    nodes_.resize(1);
+    root_ = 0;
+    freeList_ = 0;
+    size_ = 0;
+}
+
+template <typename Data>
+int
+CompactMultiSet<Data>::height() const
+{
+    return empty() ? 0 : Algorithms::height(traits(), root_);
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::begin() const
+{
+    return empty() ? end() : const_iterator(this, Algorithms::leftMost(traits(), root_));
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::end() const
+{
+    return const_iterator(this, 0);
+}
+
+/// Equal elements keep their insertion order. Returns end() when the set
+/// already holds MAX_SIZE elements.
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::insert(const value_type& x)
+{
+    const uint32_t n = allocateNode(x);
+    if (0 == n) { return end(); }
+    const NodeTraits t = traits();
+    uint32_t parent = 0;
+    bool isLeft = false;
+    for (uint32_t current = root_; current != 0;) {
+        parent = current;
+        isLeft = x < t.nodes_[current].data_;
+        current = isLeft ? t.left(current) : t.right(current);
+    }
+    Algorithms::insert(t, root_, parent, isLeft, n);
+    ++size_;
+    return const_iterator(this, n);
+}
+
+template <typename Data>
+void
+CompactMultiSet<Data>::erase(const_iterator pos)
+{
+    assert(pos != end());
+    Algorithms::erase(traits(), root_, pos.index_);
+    --size_;
+    freeNode(pos.index_);
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::erase(const key_type& k)
+{
+    size_type counter = 0;
+    const_iterator it = lower_bound(k);
+    while (it != end() && !(k < *it)) {
+        const_iterator temp = it++;
+        erase(temp);
+        ++counter;
+    }
+    return counter;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::find(const key_type& k) const
+{
+    const const_iterator it = lower_bound(k);
+    return (it == end() || k < *it) ? end() : it;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::count(const key_type& k) const
+{
+    size_type counter = 0;
+    for (const_iterator it = lower_bound(k); it != end() && !(k < *it); ++it) { ++counter; }
+    return counter;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::lower_bound(const key_type& k) const
+{
+    const Node* n = &nodes_[0];
+    uint32_t result = 0;
+    for (uint32_t current = root_; current != 0;) {
+        if (n[current].data_ < k) {
+            current = n[current].right_;
+        } else {
+            result = current;
+            current = n[current].left_;
+        }
+    }
+    return const_iterator(this, result);
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::upper_bound(const key_type& k) const
+{
+    const Node* n = &nodes_[0];
+    uint32_t result = 0;
+    for (uint32_t current = root_; current != 0;) {
+        if (k < n[current].data_) {
+            result = current;
+            current = n[current].left_;
+        } else {
+            current = n[current].right_;
+        }
+    }
+    return const_iterator(this, result);
+}
+
+template <typename Data>
+std::pair<typename CompactMultiSet<Data>::const_iterator, typename CompactMultiSet<Data>::const_iterator>
+CompactMultiSet<Data>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+/// Bytes one element takes in the pool.
+template <typename Data>
+typename CompactMultiSet<Data>::size_type
+CompactMultiSet<Data>::node_size()
+{
+    return sizeof(Node);
+}
+
+/// The traits write through the links only, the keys are never modified.
+template <typename Data>
+typename CompactMultiSet<Data>::NodeTraits
+CompactMultiSet<Data>::traits() const
+{
+    return NodeTraits(const_cast<Node*>(&nodes_[0]));
+}
+
+template <typename Data>
+uint32_t
+CompactMultiSet<Data>::allocateNode(const value_type& x)
+{
+    uint32_t n = freeList_;
+    if (n != 0) {
+        freeList_ = nodes_[n].left_;
+        nodes_[n].data_ = x;
+    } else {
+        if (size_ >= MAX_SIZE) { return 0; }
+        n = static_cast<uint32_t>(nodes_.size());
+        const Node node = { x, 0, 0, 0 };
+        nodes_.push_back(node);
+    }
+    return n;
+}
+
+template <typename Data>
+void
+CompactMultiSet<Data>::freeNode(uint32_t n)
+{
+    nodes_[n].left_ = freeList_;
+    freeList_ = n;
+}
+
+/// const_iterator
+
+template <typename Data>
+CompactMultiSet<Data>::const_iterator::const_iterator()
+    : set_(NULL), index_(0)
+{}
+
+template <typename Data>
+CompactMultiSet<Data>::const_iterator::const_iterator(const CompactMultiSet* set, uint32_t index)
+    : set_(set), index_(index)
+{}
+
+template <typename Data>
+const typename CompactMultiSet<Data>::value_type&
+CompactMultiSet<Data>::const_iterator::operator*() const
+{
+    return set_->nodes_[index_].data_;
+}
+
+template <typename Data>
+const typename CompactMultiSet<Data>::value_type*
+CompactMultiSet<Data>::const_iterator::operator->() const
+{
+    return &set_->nodes_[index_].data_;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator&
+CompactMultiSet<Data>::const_iterator::operator++()
+{
+    index_ = Algorithms::next(set_->traits(), index_);
+    return *this;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::const_iterator::operator++(int)
+{
+    const const_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+/// Decrementing end() moves to the largest element.
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator&
+CompactMultiSet<Data>::const_iterator::operator--()
+{
+    const NodeTraits t = set_->traits();
+    index_ = (0 == index_) ? Algorithms::rightMost(t, set_->root_) : Algorithms::prev(t, index_);
+    return *this;
+}
+
+template <typename Data>
+typename CompactMultiSet<Data>::const_iterator
+CompactMultiSet<Data>::const_iterator::operator--(int)
+{
+    const const_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+template <typename Data>
+bool
+CompactMultiSet<Data>::const_iterator::operator==(const const_iterator& rhv) const
+{
+    return index_ == rhv.index_;
+}
+
+template <typename Data>
+bool
+CompactMultiSet<Data>::const_iterator::operator!=(const const_iterator& rhv) const
+{
+    return !(*this == rhv);
+}
+
@@ -0,0 +1,203 @@
+#include "headers/FrozenBlockMultiSet.hpp"
+#include <algorithm>
+#include <limits>
+
+template <typename Data>
+FrozenBlockMultiSet<Data>::FrozenBlockMultiSet()
+    : size_(0)
+    , kernels_(SimdSearch<Data>::kernels())
+{
+    build();
+}
+
+/// Takes count elements in sorted order starting at sortedFirst.
+template <typename Data>
+template <typename InputIt>
+FrozenBlockMultiSet<Data>::FrozenBlockMultiSet(InputIt sortedFirst, size_type count)
+    : size_(count)
+    , kernels_(SimdSearch<Data>::kernels())
+{
+    static_assert(std::is_arithmetic<Data>::value, "FrozenBlockMultiSet needs arithmetic keys");
+    leaves_.reserve((count / BLOCK + 1) * BLOCK);
+    for (size_type i = 0; i < count; ++i, ++sortedFirst) { leaves_.push_back(*sortedFirst); }
+    build();
+}
+
+template <typename Data>
+void
+FrozenBlockMultiSet<Data>::swap(FrozenBlockMultiSet& rhv)
+{
+    leaves_.swap(rhv.leaves_);
+    nodes_.swap(rhv.nodes_);
+    levelOffset_.swap(rhv.levelOffset_);
+    levelBlocks_.swap(rhv.levelBlocks_);
+    std::swap(size_, rhv.size_);
+}
+
+/// Pads the leaves to whole blocks with a key not less than any element and
+/// builds the internal levels bottom up. Separator j of a node is the
+/// smallest key in the subtree of child j + 1.
+template <typename Data>
+void
+FrozenBlockMultiSet<Data>::build()
+{
+    leaves_.resize(std::max<size_type>(1, (size_ + BLOCK - 1) / BLOCK) * BLOCK, padding());
+    levelOffset_.assign(1, 0);
+    levelBlocks_.assign(1, leaves_.size() / BLOCK);
+    nodes_.clear();
+    size_type leavesPerChild = 1;
+    while (levelBlocks_.back() > 1) {
+        const size_type children = levelBlocks_.back();
+        const size_type blocks = (children + BLOCK) / (BLOCK + 1);
+        levelOffset_.push_back(nodes_.size() / BLOCK);
+        levelBlocks_.push_back(blocks);
+        for (size_type node = 0; node < blocks; ++node) {
+            for (size_type j = 0; j < size_type(BLOCK); ++j) {
+                const size_type leaf = (node * (BLOCK + 1) + j + 1) * leavesPerChild;
+                nodes_.push_back(leaf < levelBlocks_[0] ? leaves_[leaf * BLOCK] : padding());
+            }
+        }
+        leavesPerChild *= BLOCK + 1;
+    }
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::size_type
+FrozenBlockMultiSet<Data>::size() const
+{
+    return size_;
+}
+
+template <typename Data>
+bool
+FrozenBlockMultiSet<Data>::empty() const
+{
+    return 0 == size_;
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::const_iterator
+FrozenBlockMultiSet<Data>::begin() const
+{
+    return &leaves_[0];
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::const_iterator
+FrozenBlockMultiSet<Data>::end() const
+{
+    return &leaves_[0] + size_;
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::const_iterator
+FrozenBlockMultiSet<Data>::find(const key_type& k) const
+{
+    const const_iterator it = lower_bound(k);
+    return (it == end() || k < *it) ? end() : it;
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::size_type
+FrozenBlockMultiSet<Data>::count(const key_type& k) const
+{
+    return search(k, kernels_.lessEqual_) - search(k, kernels_.less_);
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::const_iterator
+FrozenBlockMultiSet<Data>::lower_bound(const key_type& k) const
+{
+    return begin() + search(k, kernels_.less_);
+}
+
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::const_iterator
+FrozenBlockMultiSet<Data>::upper_bound(const key_type& k) const
+{
+    return begin() + search(k, kernels_.lessEqual_);
+}
+
+template <typename Data>
+std::pair<typename FrozenBlockMultiSet<Data>::const_iterator, typename FrozenBlockMultiSet<Data>::const_iterator>
+FrozenBlockMultiSet<Data>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+template <typename Data>
+void
+FrozenBlockMultiSet<Data>::lower_bound_batch(const key_type* keys, size_type count, size_type* positions) const
+{
+    searchBatch(keys, count, positions, kernels_.less_);
+}
+
+template <typename Data>
+void
+FrozenBlockMultiSet<Data>::count_batch(const key_type* keys, size_type count, size_type* counts) const
+{
+    const size_type GROUP = 64;
+    size_type lower[GROUP];
+    for (size_type first = 0; first < count; first += GROUP) {
+        const size_type group = std::min(GROUP, count - first);
+        searchBatch(keys + first, group, lower, kernels_.less_);
+        searchBatch(keys + first, group, counts + first, kernels_.lessEqual_);
+        for (size_type i = 0; i < group; ++i) { counts[first + i] -= lower[i]; }
+    }
+}
+
+template <typename Data>
+const char*
+FrozenBlockMultiSet<Data>::instruction_set()
+{
+    return SimdSearch<Data>::instructionSet();
+}
+
+/// Rank of the first key for which the kernel predicate fails. The child
+/// index is clamped because padding separators may count as less or equal.
+template <typename Data>
+typename FrozenBlockMultiSet<Data>::size_type
+FrozenBlockMultiSet<Data>::search(const key_type& k, typename SimdSearch<Data>::Kernel kernel) const
+{
+    size_type node = 0;
+    for (size_type level = levelBlocks_.size() - 1; level > 0; --level) {
+        const Data* block = &nodes_[(levelOffset_[level] + node) * BLOCK];
+        node = std::min(node * (BLOCK + 1) + kernel(block, k), levelBlocks_[level - 1] - 1);
+    }
+    return std::min(node * BLOCK + kernel(&leaves_[node * BLOCK], k), size_);
+}
+
+template <typename Data>
+void
+FrozenBlockMultiSet<Data>::searchBatch(const key_type* keys, size_type count, size_type* positions,
+                                       typename SimdSearch<Data>::Kernel kernel) const
+{
+    const size_type GROUP = 16;
+    size_type node[GROUP];
+    for (size_type first = 0; first < count; first += GROUP) {
+        const size_type group = std::min(GROUP, count - first);
+        std::fill(node, node + group, 0);
+        for (size_type level = levelBlocks_.size() - 1; level > 0; --level) {
+            for (size_type i = 0; i < group; ++i) {
+                const Data* block = &nodes_[(levelOffset_[level] + node[i]) * BLOCK];
+                node[i] = std::min(node[i] * (BLOCK + 1) + kernel(block, keys[first + i]),
+                                   levelBlocks_[level - 1] - 1);
+                __builtin_prefetch(level > 1 ? &nodes_[(levelOffset_[level - 1] + node[i]) * BLOCK]
+                                             : &leaves_[node[i] * BLOCK]);
+            }
+        }
+        for (size_type i = 0; i < group; ++i) {
+            positions[first + i] = std::min(node[i] * BLOCK + kernel(&leaves_[node[i] * BLOCK], keys[first + i]),
+                                            size_);
+        }
+    }
+}
+
+template <typename Data>
+Data
+FrozenBlockMultiSet<Data>::padding()
+{
+    return std::numeric_limits<Data>::has_infinity ? std::numeric_limits<Data>::infinity()
+                                                   : std::numeric_limits<Data>::max();
+}
+
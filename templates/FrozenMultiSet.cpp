@@ -0,0 +1,297 @@
+#include "headers/FrozenMultiSet.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdint.h>
+
+template <typename Data>
+FrozenMultiSet<Data>::FrozenMultiSet()
+    : keys_(1), size_(0), levels_(0)
+{}
+
+/// Takes count elements in sorted order starting at sortedFirst.
+template <typename Data>
+template <typename InputIt>
+FrozenMultiSet<Data>::FrozenMultiSet(InputIt sortedFirst, size_type count)
+    : keys_(count + 1), size_(count), levels_(0)
+{
+    while ((size_type(1) << levels_) <= count) { ++levels_; }
+    fillHelper(1, sortedFirst);
+}
+
+template <typename Data>
+void
+FrozenMultiSet<Data>::swap(FrozenMultiSet& rhv)
+{
+    keys_.swap(rhv.keys_);
+    std::swap(size_, rhv.size_);
+    std::swap(levels_, rhv.levels_);
+}
+
+template <typename Data>
+template <typename InputIt>
+void
+FrozenMultiSet<Data>::fillHelper(size_type index, InputIt& sortedFirst)
+{
+    if (index > size_) { return; }
+    fillHelper(2 * index, sortedFirst);
+    keys_[index] = *sortedFirst;
+    ++sortedFirst;
+    fillHelper(2 * index + 1, sortedFirst);
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::size() const
+{
+    return size_;
+}
+
+template <typename Data>
+bool
+FrozenMultiSet<Data>::empty() const
+{
+    return 0 == size_;
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::begin() const
+{
+    if (empty()) { return end(); }
+    size_type index = 1;
+    while (2 * index <= size_) { index *= 2; }
+    return const_iterator(this, index);
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::end() const
+{
+    return const_iterator(this, 0);
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::find(const key_type& k) const
+{
+    const size_type index = lowerIndex(k);
+    return (0 == index || k < keys_[index]) ? end() : const_iterator(this, index);
+}
+
+/// Two rank descents, so the cost does not depend on the number of
+/// equal elements.
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::count(const key_type& k) const
+{
+    return rank(k, true) - rank(k, false);
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::lower_bound(const key_type& k) const
+{
+    return const_iterator(this, lowerIndex(k));
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::upper_bound(const key_type& k) const
+{
+    return const_iterator(this, upperIndex(k));
+}
+
+template <typename Data>
+std::pair<typename FrozenMultiSet<Data>::const_iterator, typename FrozenMultiSet<Data>::const_iterator>
+FrozenMultiSet<Data>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+/// The descent only decides left or right, the answer is the last node
+/// where it went left: strip the trailing right turns and that one left turn.
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::lowerIndex(const key_type& k) const
+{
+    const Data* keys = &keys_[0];
+    size_type index = 1;
+    while (index <= size_) {
+        prefetch(index);
+        index = 2 * index + (keys[index] < k);
+    }
+    return resolve(index);
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::upperIndex(const key_type& k) const
+{
+    const Data* keys = &keys_[0];
+    size_type index = 1;
+    while (index <= size_) {
+        prefetch(index);
+        index = 2 * index + !(k < keys[index]);
+    }
+    return resolve(index);
+}
+
+/// Number of elements less than k (or not greater than k when isUpper).
+/// Every right turn skips the left subtree, whose size follows from the
+/// shape of the implicit tree.
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::rank(const key_type& k, bool isUpper) const
+{
+    const Data* keys = &keys_[0];
+    size_type index = 1;
+    size_type result = 0;
+    for (int depth = 0; index <= size_; ++depth) {
+        prefetch(index);
+        const bool goRight = isUpper ? !(k < keys[index]) : keys[index] < k;
+        result += goRight ? leftSubtreeSize(index, depth) + 1 : 0;
+        index = 2 * index + goRight;
+    }
+    return result;
+}
+
+/// All levels of a subtree are full except the last one of the whole tree.
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::leftSubtreeSize(size_type index, int depth) const
+{
+    const size_type left = 2 * index;
+    if (left > size_) { return 0; }
+    const int levelsBelow = levels_ - 2 - depth;
+    const size_type lastLevelWidth = size_type(1) << levelsBelow;
+    const size_type lastLevelFirst = left << levelsBelow;
+    const size_type lastLevelCount = size_ >= lastLevelFirst
+                                   ? std::min(size_ - lastLevelFirst + 1, lastLevelWidth)
+                                   : 0;
+    return lastLevelWidth - 1 + lastLevelCount;
+}
+
+/// The 16 descendants four levels below index are contiguous; fetch the
+/// cache line that holds them. Prefetching never faults, so the address
+/// may point past the array.
+template <typename Data>
+void
+FrozenMultiSet<Data>::prefetch(size_type index) const
+{
+    const uintptr_t address = reinterpret_cast<uintptr_t>(&keys_[0]) + 16 * index * sizeof(Data);
+    __builtin_prefetch(reinterpret_cast<const void*>(address));
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::resolve(size_type index)
+{
+    return index >> __builtin_ffsll(~static_cast<unsigned long long>(index));
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::next(size_type index) const
+{
+    if (2 * index + 1 <= size_) {
+        index = 2 * index + 1;
+        while (2 * index <= size_) { index *= 2; }
+        return index;
+    }
+    return resolve(index);
+}
+
+/// Stepping back from end() gives the largest element.
+template <typename Data>
+typename FrozenMultiSet<Data>::size_type
+FrozenMultiSet<Data>::prev(size_type index) const
+{
+    if (0 == index) {
+        if (empty()) { return 0; }
+        index = 1;
+        while (2 * index + 1 <= size_) { index = 2 * index + 1; }
+        return index;
+    }
+    if (2 * index <= size_) {
+        index = 2 * index;
+        while (2 * index + 1 <= size_) { index = 2 * index + 1; }
+        return index;
+    }
+    return index >> __builtin_ffsll(static_cast<unsigned long long>(index));
+}
+
+/// const_iterator
+
+template <typename Data>
+FrozenMultiSet<Data>::const_iterator::const_iterator()
+    : set_(NULL), index_(0)
+{}
+
+template <typename Data>
+FrozenMultiSet<Data>::const_iterator::const_iterator(const FrozenMultiSet* set, size_type index)
+    : set_(set), index_(index)
+{}
+
+template <typename Data>
+const typename FrozenMultiSet<Data>::value_type&
+FrozenMultiSet<Data>::const_iterator::operator*() const
+{
+    assert(index_ != 0);
+    return set_->keys_[index_];
+}
+
+template <typename Data>
+const typename FrozenMultiSet<Data>::value_type*
+FrozenMultiSet<Data>::const_iterator::operator->() const
+{
+    return &**this;
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator&
+FrozenMultiSet<Data>::const_iterator::operator++()
+{
+    index_ = set_->next(index_);
+    return *this;
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::const_iterator::operator++(int)
+{
+    const const_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator&
+FrozenMultiSet<Data>::const_iterator::operator--()
+{
+    index_ = set_->prev(index_);
+    return *this;
+}
+
+template <typename Data>
+typename FrozenMultiSet<Data>::const_iterator
+FrozenMultiSet<Data>::const_iterator::operator--(int)
+{
+    const const_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+template <typename Data>
+bool
+FrozenMultiSet<Data>::const_iterator::operator==(const const_iterator& rhv) const
+{
+    return index_ == rhv.index_;
+}
+
+template <typename Data>
+bool
+FrozenMultiSet<Data>::const_iterator::operator!=(const const_iterator& rhv) const
+{
+    return !(*this == rhv);
+}
+
@@ -0,0 +1,315 @@
+#include "headers/IntrusiveMultiSet.hpp"
+#include <cassert>
+#include <type_traits>
+
+template <typename Data, MultiSetHook Data::*Hook>
+IntrusiveMultiSet<Data, Hook>::IntrusiveMultiSet()
+    : root_(NULL), size_(0)
+{}
+
+/// The objects stay alive, they are only unlinked.
+template <typename Data, MultiSetHook Data::*Hook>
+IntrusiveMultiSet<Data, Hook>::~IntrusiveMultiSet()
+{
+    clear();
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+void
+IntrusiveMultiSet<Data, Hook>::swap(IntrusiveMultiSet& rhv)
+{
+    std::swap(root_, rhv.root_);
+    std::swap(size_, rhv.size_);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::size_type
+IntrusiveMultiSet<Data, Hook>::size() const
+{
+    return size_;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+bool
+IntrusiveMultiSet<Data, Hook>::empty() const
+{
+    return 0 == size_;
+}
+
+/// Unlinks every object bottom up, so no rebalancing is done.
+template <typename Data, MultiSetHook Data::*Hook>
+void
+IntrusiveMultiSet<Data, Hook>::clear()
+{
+    MultiSetHook* current = root_;
+    while (current != NULL) {
+        if (current->left_ != NULL) {
+            current = current->left_;
+        } else if (current->right_ != NULL) {
+            current = current->right_;
+        } else {
+            MultiSetHook* parent = current->parent_;
+            if (parent != NULL) {
+                (parent->left_ == current ? parent->left_ : parent->right_) = NULL;
+            }
+            unlinkHook(current);
+            current = parent;
+        }
+    }
+    root_ = NULL;
+    size_ = 0;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+int
+IntrusiveMultiSet<Data, Hook>::height() const
+{
+    return empty() ? 0 : Algorithms::height(NodeTraits(), root_);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::begin() const
+{
+    return empty() ? end() : iterator(this, Algorithms::leftMost(NodeTraits(), root_));
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::end() const
+{
+    return iterator(this, NULL);
+}
+
+/// x must be linked into this set.
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::iterator_to(value_type& x) const
+{
+    assert(toHook(x)->is_linked());
+    return iterator(this, toHook(x));
+}
+
+/// Equal elements keep their insertion order. x must not be linked yet.
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::insert(value_type& x)
+{
+    MultiSetHook* hook = toHook(x);
+    assert(!hook->is_linked());
+    MultiSetHook* parent = NULL;
+    bool isLeft = false;
+    for (MultiSetHook* current = root_; current != NULL;) {
+        parent = current;
+        isLeft = x < toValue(current);
+        current = isLeft ? current->left_ : current->right_;
+    }
+    Algorithms::insert(NodeTraits(), root_, parent, isLeft, hook);
+    hook->isLinked_ = true;
+    ++size_;
+    return iterator(this, hook);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+void
+IntrusiveMultiSet<Data, Hook>::erase(iterator pos)
+{
+    assert(pos != end());
+    Algorithms::erase(NodeTraits(), root_, pos.hook_);
+    unlinkHook(pos.hook_);
+    --size_;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::size_type
+IntrusiveMultiSet<Data, Hook>::erase(const key_type& k)
+{
+    size_type counter = 0;
+    iterator it = lower_bound(k);
+    while (it != end() && !(k < *it)) {
+        iterator temp = it++;
+        erase(temp);
+        ++counter;
+    }
+    return counter;
+}
+
+/// Takes out x itself, not the other objects equal to it. x must be
+/// linked into this set.
+template <typename Data, MultiSetHook Data::*Hook>
+void
+IntrusiveMultiSet<Data, Hook>::unlink(value_type& x)
+{
+    erase(iterator_to(x));
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::find(const key_type& k) const
+{
+    const iterator it = lower_bound(k);
+    return (it == end() || k < *it) ? end() : it;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::size_type
+IntrusiveMultiSet<Data, Hook>::count(const key_type& k) const
+{
+    size_type counter = 0;
+    for (iterator it = lower_bound(k); it != end() && !(k < *it); ++it) { ++counter; }
+    return counter;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::lower_bound(const key_type& k) const
+{
+    MultiSetHook* result = NULL;
+    for (MultiSetHook* current = root_; current != NULL;) {
+        if (toValue(current) < k) {
+            current = current->right_;
+        } else {
+            result = current;
+            current = current->left_;
+        }
+    }
+    return iterator(this, result);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::upper_bound(const key_type& k) const
+{
+    MultiSetHook* result = NULL;
+    for (MultiSetHook* current = root_; current != NULL;) {
+        if (k < toValue(current)) {
+            result = current;
+            current = current->left_;
+        } else {
+            current = current->right_;
+        }
+    }
+    return iterator(this, result);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+std::pair<typename IntrusiveMultiSet<Data, Hook>::iterator, typename IntrusiveMultiSet<Data, Hook>::iterator>
+IntrusiveMultiSet<Data, Hook>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+MultiSetHook*
+IntrusiveMultiSet<Data, Hook>::toHook(value_type& x)
+{
+    return &(x.*Hook);
+}
+
+/// Steps back from the hook to its enclosing object by the offset of the
+/// member.
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::value_type&
+IntrusiveMultiSet<Data, Hook>::toValue(MultiSetHook* hook)
+{
+    static const std::ptrdiff_t offset = hookOffset();
+    return *reinterpret_cast<Data*>(reinterpret_cast<char*>(hook) - offset);
+}
+
+/// Measured once on real storage for a Data, so that no pointer is made up
+/// out of an integer. The storage is never constructed; only the address
+/// of the member is taken.
+template <typename Data, MultiSetHook Data::*Hook>
+std::ptrdiff_t
+IntrusiveMultiSet<Data, Hook>::hookOffset()
+{
+    static typename std::aligned_storage<sizeof(Data), alignof(Data)>::type storage;
+    Data* const object = reinterpret_cast<Data*>(&storage);
+    return reinterpret_cast<char*>(&(object->*Hook)) - reinterpret_cast<char*>(object);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+void
+IntrusiveMultiSet<Data, Hook>::unlinkHook(MultiSetHook* hook)
+{
+    hook->parent_ = hook->left_ = hook->right_ = NULL;
+    hook->balance_ = 0;
+    hook->isLinked_ = false;
+}
+
+/// iterator
+
+template <typename Data, MultiSetHook Data::*Hook>
+IntrusiveMultiSet<Data, Hook>::iterator::iterator()
+    : set_(NULL), hook_(NULL)
+{}
+
+template <typename Data, MultiSetHook Data::*Hook>
+IntrusiveMultiSet<Data, Hook>::iterator::iterator(const IntrusiveMultiSet* set, MultiSetHook* hook)
+    : set_(set), hook_(hook)
+{}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::value_type&
+IntrusiveMultiSet<Data, Hook>::iterator::operator*() const
+{
+    return toValue(hook_);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::value_type*
+IntrusiveMultiSet<Data, Hook>::iterator::operator->() const
+{
+    return &toValue(hook_);
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator&
+IntrusiveMultiSet<Data, Hook>::iterator::operator++()
+{
+    hook_ = Algorithms::next(NodeTraits(), hook_);
+    return *this;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::iterator::operator++(int)
+{
+    const iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+/// Decrementing end() moves to the largest element.
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator&
+IntrusiveMultiSet<Data, Hook>::iterator::operator--()
+{
+    hook_ = (NULL == hook_) ? Algorithms::rightMost(NodeTraits(), set_->root_)
+                            : Algorithms::prev(NodeTraits(), hook_);
+    return *this;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+typename IntrusiveMultiSet<Data, Hook>::iterator
+IntrusiveMultiSet<Data, Hook>::iterator::operator--(int)
+{
+    const iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+bool
+IntrusiveMultiSet<Data, Hook>::iterator::operator==(const iterator& rhv) const
+{
+    return hook_ == rhv.hook_;
+}
+
+template <typename Data, MultiSetHook Data::*Hook>
+bool
+IntrusiveMultiSet<Data, Hook>::iterator::operator!=(const iterator& rhv) const
+{
+    return !(*this == rhv);
+}
+
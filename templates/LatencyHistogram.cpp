@@ -0,0 +1,104 @@
+#include "headers/LatencyHistogram.hpp"
+#include <algorithm>
+#include <limits>
+
+inline
+LatencyHistogram::LatencyHistogram()
+    : counts_(bucketOf(std::numeric_limits<uint64_t>::max()) + 1, 0)
+    , count_(0)
+    , min_(std::numeric_limits<uint64_t>::max())
+    , max_(0)
+    , sum_(0)
+{}
+
+inline void
+LatencyHistogram::record(uint64_t nanoseconds)
+{
+    ++counts_[bucketOf(nanoseconds)];
+    ++count_;
+    min_ = std::min(min_, nanoseconds);
+    max_ = std::max(max_, nanoseconds);
+    sum_ += static_cast<double>(nanoseconds);
+}
+
+inline void
+LatencyHistogram::merge(const LatencyHistogram& rhv)
+{
+    for (std::size_t i = 0; i < counts_.size(); ++i) { counts_[i] += rhv.counts_[i]; }
+    count_ += rhv.count_;
+    min_ = std::min(min_, rhv.min_);
+    max_ = std::max(max_, rhv.max_);
+    sum_ += rhv.sum_;
+}
+
+inline void
+LatencyHistogram::reset()
+{
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+    sum_ = 0;
+}
+
+inline uint64_t
+LatencyHistogram::count() const
+{
+    return count_;
+}
+
+inline uint64_t
+LatencyHistogram::min() const
+{
+    return 0 == count_ ? 0 : min_;
+}
+
+inline uint64_t
+LatencyHistogram::max() const
+{
+    return max_;
+}
+
+inline double
+LatencyHistogram::mean() const
+{
+    return 0 == count_ ? 0 : sum_ / count_;
+}
+
+/// The bound is clamped to max so that the 100th percentile is exact.
+inline uint64_t
+LatencyHistogram::percentile(double percent) const
+{
+    if (0 == count_) { return 0; }
+    const double wanted = percent / 100 * count_;
+    uint64_t rank = static_cast<uint64_t>(wanted);
+    if (rank < wanted || 0 == rank) { ++rank; }
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) { return std::min(highestValueOf(i), max_); }
+    }
+    return max_;
+}
+
+/// Values below SUB_BUCKETS map to themselves. Above, a value whose top
+/// bit is b keeps its top SUB_BUCKET_BITS - 1 bits below that one, giving
+/// SUB_BUCKETS / 2 buckets for every power of two.
+inline std::size_t
+LatencyHistogram::bucketOf(uint64_t value)
+{
+    if (value < SUB_BUCKETS) { return static_cast<std::size_t>(value); }
+    const int shift = 63 - __builtin_clzll(value) - (SUB_BUCKET_BITS - 1);
+    const uint64_t top = value >> shift;
+    return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2) + static_cast<std::size_t>(top - SUB_BUCKETS / 2);
+}
+
+inline uint64_t
+LatencyHistogram::highestValueOf(std::size_t bucket)
+{
+    if (bucket < SUB_BUCKETS) { return bucket; }
+    const std::size_t shift = (bucket - SUB_BUCKETS) / (SUB_BUCKETS / 2) + 1;
+    const uint64_t top = (bucket - SUB_BUCKETS) % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+    return ((top + 1) << shift) - 1;
+}
+
@@ -0,0 +1,262 @@
+#include "headers/MultiSetBalance.hpp"
+#include <algorithm>
+
+/// AvlBalance
+
+template <typename Node>
+int
+AvlBalance::height(const Node* n)
+{
+    return NULL == n ? 0 : n->balance_;
+}
+
+template <typename Node>
+void
+AvlBalance::update(Node* n)
+{
+    n->balance_ = static_cast<Info>(1 + std::max(height(n->left_), height(n->right_)));
+}
+
+/// Rebalances the subtree of n with one single or double rotation and
+/// returns its new root.
+template <typename Tree, typename Node>
+Node*
+AvlBalance::fix(Tree& tree, Node* n)
+{
+    const int factor = height(n->right_) - height(n->left_);
+    if (factor > 1) {
+        if (height(n->right_->left_) > height(n->right_->right_)) { tree.rotateUp(n->right_->left_); }
+        return tree.rotateUp(n->right_);
+    }
+    if (factor < -1) {
+        if (height(n->left_->right_) > height(n->left_->left_)) { tree.rotateUp(n->left_->right_); }
+        return tree.rotateUp(n->left_);
+    }
+    update(n);
+    return n;
+}
+
+template <typename Tree, typename Node>
+void
+AvlBalance::afterInsert(Tree& tree, Node* n)
+{
+    for (Node* parent = n->parent_; parent != NULL;) {
+        tree.onRetraceStep();
+        const Info oldHeight = parent->balance_;
+        Node* top = fix(tree, parent);
+        if (top->balance_ == oldHeight) { return; }
+        parent = top->parent_;
+    }
+}
+
+template <typename Tree, typename Node>
+void
+AvlBalance::afterErase(Tree& tree, Node* parent, Node*, bool, Info)
+{
+    while (parent != NULL) {
+        tree.onRetraceStep();
+        const Info oldHeight = parent->balance_;
+        Node* top = fix(tree, parent);
+        if (top->balance_ == oldHeight) { return; }
+        parent = top->parent_;
+    }
+}
+
+template <typename Node>
+void
+AvlBalance::afterBuild(Node* n, int, int)
+{
+    update(n);
+}
+
+template <typename Node>
+long
+AvlBalance::check(const Node* n)
+{
+    if (NULL == n) { return 0; }
+    const long left = check(n->left_);
+    const long right = check(n->right_);
+    if (left < 0 || right < 0 || left - right > 1 || right - left > 1) { return -1; }
+    const long h = std::max(left, right) + 1;
+    return h == n->balance_ ? h : -1;
+}
+
+/// RedBlackBalance
+
+template <typename Node>
+bool
+RedBlackBalance::isRed(const Node* n)
+{
+    return n != NULL && RED == n->balance_;
+}
+
+template <typename Tree, typename Node>
+void
+RedBlackBalance::afterInsert(Tree& tree, Node* n)
+{
+    while (isRed(n->parent_)) {
+        tree.onRetraceStep();
+        Node* parent = n->parent_;
+        Node* grandParent = parent->parent_;
+        const bool isParentLeft = grandParent->left_ == parent;
+        Node* uncle = isParentLeft ? grandParent->right_ : grandParent->left_;
+        if (isRed(uncle)) {
+            parent->balance_ = BLACK;
+            uncle->balance_ = BLACK;
+            grandParent->balance_ = RED;
+            n = grandParent;
+            continue;
+        }
+        if (isParentLeft != (parent->left_ == n)) {
+            tree.rotateUp(n);
+            parent = n;
+        }
+        tree.rotateUp(parent);
+        parent->balance_ = BLACK;
+        grandParent->balance_ = RED;
+        break;
+    }
+    tree.root_->balance_ = BLACK;
+}
+
+/// Removing a black node leaves its side one black short; the deficit is
+/// pushed up by recoloring or resolved by rotations around the sibling.
+template <typename Tree, typename Node>
+void
+RedBlackBalance::afterErase(Tree& tree, Node* parent, Node* child, bool isLeft, Info removed)
+{
+    if (RED == removed) { return; }
+    while (parent != NULL && !isRed(child)) {
+        tree.onRetraceStep();
+        Node* sibling = isLeft ? parent->right_ : parent->left_;
+        if (isRed(sibling)) {
+            sibling->balance_ = BLACK;
+            parent->balance_ = RED;
+            tree.rotateUp(sibling);
+            sibling = isLeft ? parent->right_ : parent->left_;
+        }
+        Node* nearChild = isLeft ? sibling->left_ : sibling->right_;
+        Node* farChild = isLeft ? sibling->right_ : sibling->left_;
+        if (!isRed(nearChild) && !isRed(farChild)) {
+            sibling->balance_ = RED;
+            child = parent;
+            parent = child->parent_;
+            if (parent != NULL) { isLeft = parent->left_ == child; }
+            continue;
+        }
+        if (!isRed(farChild)) {
+            nearChild->balance_ = BLACK;
+            sibling->balance_ = RED;
+            tree.rotateUp(nearChild);
+            farChild = sibling;
+            sibling = nearChild;
+        }
+        sibling->balance_ = parent->balance_;
+        parent->balance_ = BLACK;
+        farChild->balance_ = BLACK;
+        tree.rotateUp(sibling);
+        child = tree.root_;
+        break;
+    }
+    if (child != NULL) { child->balance_ = BLACK; }
+}
+
+/// Only an incomplete last level is red, every path then has maxDepth
+/// black nodes.
+template <typename Node>
+void
+RedBlackBalance::afterBuild(Node* n, int depth, int maxDepth)
+{
+    n->balance_ = (depth == maxDepth && depth > 0) ? RED : BLACK;
+}
+
+/// The root must be black, and a red node has no red child.
+template <typename Node>
+long
+RedBlackBalance::check(const Node* n)
+{
+    if (NULL == n) { return 1; }
+    if (NULL == n->parent_ && isRed(n)) { return -1; }
+    if (isRed(n) && (isRed(n->left_) || isRed(n->right_))) { return -1; }
+    const long left = check(n->left_);
+    const long right = check(n->right_);
+    if (left < 0 || left != right) { return -1; }
+    return left + (isRed(n) ? 0 : 1);
+}
+
+/// WeightBalance
+
+template <typename Node>
+std::size_t
+WeightBalance::weight(const Node* n)
+{
+    return NULL == n ? 1 : n->balance_ + 1;
+}
+
+template <typename Node>
+void
+WeightBalance::update(Node* n)
+{
+    n->balance_ = weight(n->left_) + weight(n->right_) - 1;
+}
+
+template <typename Tree, typename Node>
+Node*
+WeightBalance::fix(Tree& tree, Node* n)
+{
+    const std::size_t leftWeight = weight(n->left_);
+    const std::size_t rightWeight = weight(n->right_);
+    if (rightWeight > DELTA * leftWeight) {
+        Node* right = n->right_;
+        if (weight(right->left_) >= GAMMA * weight(right->right_)) { tree.rotateUp(right->left_); }
+        return tree.rotateUp(n->right_);
+    }
+    if (leftWeight > DELTA * rightWeight) {
+        Node* left = n->left_;
+        if (weight(left->right_) >= GAMMA * weight(left->left_)) { tree.rotateUp(left->right_); }
+        return tree.rotateUp(n->left_);
+    }
+    update(n);
+    return n;
+}
+
+/// Every size on the path changes, so the walk always goes to the root.
+template <typename Tree, typename Node>
+void
+WeightBalance::afterInsert(Tree& tree, Node* n)
+{
+    for (Node* parent = n->parent_; parent != NULL; parent = fix(tree, parent)->parent_) {
+        tree.onRetraceStep();
+    }
+}
+
+template <typename Tree, typename Node>
+void
+WeightBalance::afterErase(Tree& tree, Node* parent, Node*, bool, Info)
+{
+    for (; parent != NULL; parent = fix(tree, parent)->parent_) {
+        tree.onRetraceStep();
+    }
+}
+
+template <typename Node>
+void
+WeightBalance::afterBuild(Node* n, int, int)
+{
+    update(n);
+}
+
+/// Neither side may outweigh the other by more than DELTA.
+template <typename Node>
+long
+WeightBalance::check(const Node* n)
+{
+    if (NULL == n) { return 0; }
+    const long left = check(n->left_);
+    const long right = check(n->right_);
+    if (left < 0 || right < 0) { return -1; }
+    if (left + 1 > DELTA * (right + 1) || right + 1 > DELTA * (left + 1)) { return -1; }
+    const long size = left + right + 1;
+    return static_cast<long>(n->balance_) == size ? size : -1;
+}
+
@@ -0,0 +1,105 @@
+#include "headers/MultiSetInstrumentation.hpp"
+#include <chrono>
+
+/// CountingInstrumentation::Scope
+
+inline
+CountingInstrumentation::Scope::Scope(const CountingInstrumentation& owner, MultiSetOperation operation)
+    : owner_(owner)
+    , operation_(operation)
+    , start_(0)
+    , isSampled_(false)
+{
+    if (0 != owner_.depth_++ || NULL == owner_.sampler_) { return; }
+    if (--owner_.untilSample_ > 0) { return; }
+    owner_.untilSample_ = owner_.samplePeriod_;
+    isSampled_ = true;
+    start_ = now();
+}
+
+inline
+CountingInstrumentation::Scope::~Scope()
+{
+    --owner_.depth_;
+    if (isSampled_) {
+        owner_.sampler_(operation_, now() - start_, owner_.samplerContext_);
+    }
+}
+
+/// CountingInstrumentation
+
+inline
+CountingInstrumentation::CountingInstrumentation()
+    : counters_()
+    , sampler_(NULL)
+    , samplerContext_(NULL)
+    , samplePeriod_(1)
+    , untilSample_(1)
+    , depth_(0)
+{}
+
+inline const MultiSetCounters&
+CountingInstrumentation::counters() const
+{
+    return counters_;
+}
+
+inline void
+CountingInstrumentation::resetCounters()
+{
+    counters_ = MultiSetCounters();
+}
+
+/// Passing a null sampler switches sampling off.
+inline void
+CountingInstrumentation::setLatencySampler(Sampler sampler, void* context, uint32_t period)
+{
+    sampler_ = sampler;
+    samplerContext_ = context;
+    samplePeriod_ = period > 0 ? period : 1;
+    untilSample_ = samplePeriod_;
+}
+
+inline void
+CountingInstrumentation::onComparison(uint64_t count) const
+{
+    counters_.comparisons += count;
+}
+
+inline void
+CountingInstrumentation::onRotation() const
+{
+    ++counters_.rotations;
+}
+
+inline void
+CountingInstrumentation::onRetraceStep() const
+{
+    ++counters_.retraceSteps;
+}
+
+inline void
+CountingInstrumentation::onAllocation() const
+{
+    ++counters_.allocations;
+}
+
+inline void
+CountingInstrumentation::onFree() const
+{
+    ++counters_.frees;
+}
+
+inline void
+CountingInstrumentation::onIteratorStep(uint64_t count) const
+{
+    counters_.iteratorSteps += count;
+}
+
+inline uint64_t
+CountingInstrumentation::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
@@ -0,0 +1,148 @@
+#include "headers/MultiSetSerializer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+/// MultiSetWriter
+
+inline
+MultiSetWriter::MultiSetWriter(std::ostream& out, std::size_t bufferSize)
+    : out_(out)
+    , buffer_(bufferSize > 0 ? bufferSize : 1)
+    , used_(0)
+{}
+
+inline
+MultiSetWriter::~MultiSetWriter()
+{
+    flush();
+}
+
+inline void
+MultiSetWriter::write(const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    if (size >= buffer_.size()) {
+        flush();
+        out_.write(bytes, size);
+        return;
+    }
+    if (used_ + size > buffer_.size()) { flush(); }
+    std::memcpy(&buffer_[used_], bytes, size);
+    used_ += size;
+}
+
+template <typename T>
+void
+MultiSetWriter::writeValue(const T& value)
+{
+    write(&value, sizeof(T));
+}
+
+inline bool
+MultiSetWriter::flush()
+{
+    if (used_ > 0) {
+        out_.write(&buffer_[0], used_);
+        used_ = 0;
+    }
+    return out_.good();
+}
+
+inline bool
+MultiSetWriter::good() const
+{
+    return out_.good();
+}
+
+/// MultiSetReader
+
+inline
+MultiSetReader::MultiSetReader(std::istream& in)
+    : in_(in)
+    , good_(in.good())
+{}
+
+inline void
+MultiSetReader::read(void* data, std::size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+    const std::streamsize count = good_ ? in_.rdbuf()->sgetn(bytes, size) : 0;
+    if (static_cast<std::size_t>(count) == size) { return; }
+    std::memset(bytes + count, 0, size - count);
+    in_.setstate(std::ios::failbit);
+    good_ = false;
+}
+
+template <typename T>
+T
+MultiSetReader::readValue()
+{
+    T value;
+    read(&value, sizeof(T));
+    return value;
+}
+
+inline bool
+MultiSetReader::good() const
+{
+    return good_;
+}
+
+/// MultiSetSerializer
+
+template <typename Data>
+uint32_t
+MultiSetSerializer<Data>::elementSize()
+{
+    return sizeof(Data);
+}
+
+template <typename Data>
+void
+MultiSetSerializer<Data>::write(MultiSetWriter& out, const Data& value)
+{
+    static_assert(std::is_trivially_copyable<Data>::value,
+                  "MultiSetSerializer must be specialized for this type");
+    out.writeValue(value);
+}
+
+template <typename Data>
+Data
+MultiSetSerializer<Data>::read(MultiSetReader& in)
+{
+    static_assert(std::is_trivially_copyable<Data>::value,
+                  "MultiSetSerializer must be specialized for this type");
+    return in.readValue<Data>();
+}
+
+inline uint32_t
+MultiSetSerializer<std::string>::elementSize()
+{
+    return 0;
+}
+
+inline void
+MultiSetSerializer<std::string>::write(MultiSetWriter& out, const std::string& value)
+{
+    out.writeValue<uint64_t>(value.size());
+    out.write(value.data(), value.size());
+}
+
+inline std::string
+MultiSetSerializer<std::string>::read(MultiSetReader& in)
+{
+    const uint64_t size = in.readValue<uint64_t>();
+    std::string value;
+    if (!in.good()) { return value; }
+    /// Grow in bounded steps so that a corrupt length cannot trigger a huge allocation.
+    char chunk[4096];
+    for (uint64_t left = size; left > 0 && in.good();) {
+        const std::size_t step = left < sizeof(chunk) ? static_cast<std::size_t>(left) : sizeof(chunk);
+        in.read(chunk, step);
+        value.append(chunk, step);
+        left -= step;
+    }
+    return value;
+}
+
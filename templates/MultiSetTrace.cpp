@@ -0,0 +1,138 @@
+#include "headers/MultiSetTrace.hpp"
+#include <cstring>
+
+/// MultiSetTraceRecorder
+
+template <typename Data>
+MultiSetTraceRecorder<Data>::MultiSetTraceRecorder(std::ostream& out)
+    : writer_(out)
+    , count_(0)
+{
+    writer_.write(MULTI_SET_TRACE_MAGIC, sizeof(MULTI_SET_TRACE_MAGIC));
+    writer_.writeValue<uint32_t>(MULTI_SET_TRACE_VERSION);
+    writer_.writeValue<uint32_t>(MultiSetSerializer<Data>::elementSize());
+    writer_.writeValue<uint32_t>(MultiSetTraceKey<Data>::TYPE);
+}
+
+template <typename Data>
+void
+MultiSetTraceRecorder<Data>::record(MultiSetTraceOperation operation, const Data& key)
+{
+    writer_.writeValue<uint8_t>(static_cast<uint8_t>(operation));
+    MultiSetSerializer<Data>::write(writer_, key);
+    ++count_;
+}
+
+template <typename Data>
+void
+MultiSetTraceRecorder<Data>::record(MultiSetTraceOperation operation, const Data& lo, const Data& hi)
+{
+    record(operation, lo);
+    MultiSetSerializer<Data>::write(writer_, hi);
+}
+
+template <typename Data>
+uint64_t
+MultiSetTraceRecorder<Data>::operation_count() const
+{
+    return count_;
+}
+
+/// Records are buffered; the destructor of the writer flushes the rest.
+template <typename Data>
+bool
+MultiSetTraceRecorder<Data>::flush()
+{
+    return writer_.flush();
+}
+
+/// MultiSetTraceReader
+
+template <typename Data>
+MultiSetTraceReader<Data>::MultiSetTraceReader(std::istream& in)
+    : in_(in)
+    , reader_(in)
+    , good_(false)
+{
+    char magic[sizeof(MULTI_SET_TRACE_MAGIC)];
+    reader_.read(magic, sizeof(magic));
+    const uint32_t version = reader_.readValue<uint32_t>();
+    const uint32_t elementSize = reader_.readValue<uint32_t>();
+    const uint32_t keyType = reader_.readValue<uint32_t>();
+    good_ = reader_.good() && 0 == std::memcmp(magic, MULTI_SET_TRACE_MAGIC, sizeof(magic))
+         && MULTI_SET_TRACE_VERSION == version && MultiSetSerializer<Data>::elementSize() == elementSize
+         && static_cast<uint32_t>(MultiSetTraceKey<Data>::TYPE) == keyType;
+}
+
+template <typename Data>
+bool
+MultiSetTraceReader<Data>::next(MultiSetTraceOperation& operation, Data& key, Data& hi)
+{
+    if (!good_ || std::istream::traits_type::eof() == in_.peek()) { return false; }
+    const uint8_t code = reader_.readValue<uint8_t>();
+    operation = static_cast<MultiSetTraceOperation>(code);
+    key = MultiSetSerializer<Data>::read(reader_);
+    if (MULTISET_TRACE_RANGE_SCAN == operation) { hi = MultiSetSerializer<Data>::read(reader_); }
+    good_ = reader_.good() && code <= MULTISET_TRACE_RANGE_SCAN;
+    return good_;
+}
+
+template <typename Data>
+bool
+MultiSetTraceReader<Data>::good() const
+{
+    return good_;
+}
+
+/// TracingInstrumentation::Scope
+
+template <typename Data>
+TracingInstrumentation<Data>::Scope::Scope(const TracingInstrumentation& owner, MultiSetOperation)
+    : owner_(owner)
+{
+    ++owner_.depth_;
+}
+
+template <typename Data>
+TracingInstrumentation<Data>::Scope::~Scope()
+{
+    --owner_.depth_;
+}
+
+/// TracingInstrumentation
+
+template <typename Data>
+TracingInstrumentation<Data>::TracingInstrumentation()
+    : recorder_(NULL)
+    , depth_(0)
+{}
+
+/// Passing NULL stops recording.
+template <typename Data>
+void
+TracingInstrumentation<Data>::setTraceRecorder(MultiSetTraceRecorder<Data>* recorder)
+{
+    recorder_ = recorder;
+}
+
+template <typename Data>
+MultiSetTraceRecorder<Data>*
+TracingInstrumentation<Data>::traceRecorder() const
+{
+    return recorder_;
+}
+
+template <typename Data>
+void
+TracingInstrumentation<Data>::onTrace(MultiSetTraceOperation operation, const Data& key) const
+{
+    if (recorder_ != NULL && 1 == depth_) { recorder_->record(operation, key); }
+}
+
+template <typename Data>
+void
+TracingInstrumentation<Data>::onTrace(MultiSetTraceOperation operation, const Data& lo, const Data& hi) const
+{
+    if (recorder_ != NULL && 1 == depth_) { recorder_->record(operation, lo, hi); }
+}
+
@@ -1,62 +1,80 @@
 #include "headers/Multiset.hpp"
-#include <queue>
-#include <stack>
 #include <limits>
 #include <iomanip>
 #include <cassert>
-
-template <typename Data>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 std::ostream&
-operator<<(std::ostream& out, const MultiSet<Data>& rhv) 
+operator<<(std::ostream& out, const MultiSet<Data, Instrument, Balance, Augment>& rhv) 
 {
     rhv.outputTree(rhv.root_, out);
     return out;
 }
 
-template <typename Data>
-MultiSet<Data>::MultiSet()
-    : root_(NULL)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::MultiSet()
+    : root_(NULL), deadCount_(0), compactThreshold_(0), finger_(NULL), relocation_(NULL), arena_(NULL), isFingerEnabled_(false)
 {}
 
-template <typename Data>
-MultiSet<Data>::MultiSet(const MultiSet& rhv)
-    : root_(NULL)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::MultiSet(const MultiSet& rhv)
+    : root_(NULL), deadCount_(0), compactThreshold_(rhv.compactThreshold_)
+    , finger_(NULL), relocation_(NULL), arena_(NULL), isFingerEnabled_(rhv.isFingerEnabled_)
 {
+    if (rhv.arena_ != NULL) { arena_ = new NodeArena<Node>(rhv.arena_->is_huge_pages()); }
     insert(rhv.begin(), rhv.end());
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 template <typename InputIt>
-MultiSet<Data>::MultiSet(InputIt first, InputIt last)
-    : root_(NULL)
+MultiSet<Data, Instrument, Balance, Augment>::MultiSet(InputIt first, InputIt last)
+    : root_(NULL), deadCount_(0), compactThreshold_(0), finger_(NULL), relocation_(NULL), arena_(NULL), isFingerEnabled_(false)
 {
     insert(first, last);
 }
 
-template <typename Data>
-MultiSet<Data>::~MultiSet()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::~MultiSet()
 {
     clear();
+    NodeArena<Node>::release(arena_);
 }
 
-template <typename Data>
-const MultiSet<Data>&
-MultiSet<Data>::operator=(const MultiSet& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const MultiSet<Data, Instrument, Balance, Augment>&
+MultiSet<Data, Instrument, Balance, Augment>::operator=(const MultiSet& rhv)
 {
     insert(rhv.begin(), rhv.end());
     return *this;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::swap(MultiSet& rhv)
+MultiSet<Data, Instrument, Balance, Augment>::swap(MultiSet& rhv)
 {
     std::swap(root_, rhv.root_);
+    std::swap(deadCount_, rhv.deadCount_);
+    std::swap(compactThreshold_, rhv.compactThreshold_);
+    std::swap(finger_, rhv.finger_);
+    std::swap(relocation_, rhv.relocation_);
+    std::swap(arena_, rhv.arena_);
+    std::swap(isFingerEnabled_, rhv.isFingerEnabled_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::size_type 
-MultiSet<Data>::size() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type 
+MultiSet<Data, Instrument, Balance, Augment>::size() const
 {
     int counter = 0;
     const_iterator it = begin();
@@ -64,179 +82,350 @@ MultiSet<Data>::size() const
         ++it;
         ++counter;
     }
+    this->onIteratorStep(counter);
     return counter;
 }
 
-template <typename Data>
-typename MultiSet<Data>::size_type 
-MultiSet<Data>::max_size() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type 
+MultiSet<Data, Instrument, Balance, Augment>::max_size() const
 {
     return std::numeric_limits<size_t>::max() / sizeof(Node*); 
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const Instrument&
+MultiSet<Data, Instrument, Balance, Augment>::instrumentation() const
+{
+    return *this;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+Instrument&
+MultiSet<Data, Instrument, Balance, Augment>::instrumentation()
+{
+    return *this;
+}
+
+/// One scan over the tree. Payload covers sizeof(Data) only; memory owned
+/// by the elements themselves (string buffers and the like) is not included.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::MemoryStats
+MultiSet<Data, Instrument, Balance, Augment>::memory_stats() const
+{
+    MemoryStats stats = MemoryStats();
+    stats.height = statsHelper(root_, stats);
+    stats.payloadBytes = stats.nodeCount * sizeof(Data);
+    stats.pointerBytes = stats.nodeCount * 3 * sizeof(Node*);
+    const size_type aggregateBytes = Augment::ENABLED ? sizeof(MultiSetAggregate<aggregate_type>) : 0;
+    stats.metadataBytes = stats.nodeCount * (sizeof(typename Balance::Info) + aggregateBytes);
+    stats.paddingBytes = stats.nodeCount * sizeof(Node) - stats.payloadBytes - stats.pointerBytes - stats.metadataBytes;
+    stats.totalBytes += sizeof(*this);
+    return stats;
+}
+
+/// Checks the invariant of the balance policy over the whole tree in O(n),
+/// for tests and debugging.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::is_balanced() const
+{
+    return Balance::check(static_cast<const Node*>(root_)) >= 0;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+int
+MultiSet<Data, Instrument, Balance, Augment>::statsHelper(Node* root, MemoryStats& stats) const
+{
+    if (NULL == root) { return 0; }
+    ++stats.nodeCount;
+    const size_type allocated = allocationSize(root);
+    stats.allocatorSlackBytes += allocated - sizeof(Node);
+    stats.totalBytes += allocated;
+    const int leftHeight = statsHelper(root->left_, stats);
+    const int rightHeight = statsHelper(root->right_, stats);
+    return std::max(leftHeight, rightHeight) + 1;
+}
+
+/// Bytes the allocator really holds for a node, including its bookkeeping.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::allocationSize(Node* node) const
+{
+    if (isPooled(node)) { return sizeof(Node); }
+#if defined(__GLIBC__)
+    /// glibc keeps one size word in front of every chunk.
+    return ::malloc_usable_size(node) + sizeof(std::size_t);
+#else
+    /// Estimate for the common 16-byte granularity with one header word.
+    (void)node;
+    return (sizeof(Node) + sizeof(std::size_t) + 15) / 16 * 16;
+#endif
+}
+
+/// Number and bytes of nodes alive in all MultiSet<Data, Instrument, Balance, Augment> instances.
+/// Counted only when MULTISET_TRACK_MEMORY is defined, 0 otherwise.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::live_nodes()
+{
+#ifdef MULTISET_TRACK_MEMORY
+    return liveNodes_.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::live_bytes()
+{
+#ifdef MULTISET_TRACK_MEMORY
+    return liveBytes_.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+#ifdef MULTISET_TRACK_MEMORY
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+std::atomic<typename MultiSet<Data, Instrument, Balance, Augment>::size_type> MultiSet<Data, Instrument, Balance, Augment>::liveNodes_(0);
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+std::atomic<typename MultiSet<Data, Instrument, Balance, Augment>::size_type> MultiSet<Data, Instrument, Balance, Augment>::liveBytes_(0);
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void*
+MultiSet<Data, Instrument, Balance, Augment>::Node::operator new(std::size_t size)
+{
+    void* ptr = ::operator new(size);
+    liveNodes_.fetch_add(1, std::memory_order_relaxed);
+    liveBytes_.fetch_add(size, std::memory_order_relaxed);
+    return ptr;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::Node::operator delete(void* ptr, std::size_t size)
+{
+    liveNodes_.fetch_sub(1, std::memory_order_relaxed);
+    liveBytes_.fetch_sub(size, std::memory_order_relaxed);
+    ::operator delete(ptr);
+}
+#endif /// MULTISET_TRACK_MEMORY
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::empty() const
+MultiSet<Data, Instrument, Balance, Augment>::empty() const
 {
-    return NULL == root_;
+    return NULL == root_ || (0 != deadCount_ && begin() == end());
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::clear()
+MultiSet<Data, Instrument, Balance, Augment>::clear()
 {
     clearHelper(root_);
+    deadCount_ = 0;
+    finger_ = NULL;
+    if (relocation_ != NULL) {
+        /// Only the target of an unfinished pass can be left, and it is empty.
+        for (size_type i = 0; i < relocation_->blocks_.size(); ++i) {
+            ::operator delete(relocation_->blocks_[i].nodes_);
+        }
+        delete relocation_;
+        relocation_ = NULL;
+    }
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::clearHelper(Node*& root) 
+MultiSet<Data, Instrument, Balance, Augment>::clearHelper(Node*& root) 
 {
     if (NULL == root) { return; }
     clearHelper(root->left_);
     clearHelper(root->right_);
-    delete root;
+    freeNode(root);
+    this->onFree();
     root = NULL;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::begin()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::begin()
 {
-    return iterator(getLeftMost(root_));
+    Node* first = getLeftMost(root_);
+    return iterator((0 != deadCount_ && first != NULL && first->balance_.isDead()) ? nextNode(first) : first);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::end()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::end()
 {
     return iterator(NULL);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::begin() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::begin() const
 {
-    return iterator(getLeftMost(root_));
+    Node* first = getLeftMost(root_);
+    return iterator((0 != deadCount_ && first != NULL && first->balance_.isDead()) ? nextNode(first) : first);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::end() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::end() const
 {
     return const_iterator(NULL);
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::rbegin()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::rbegin()
 {
-    return reverse_iterator(getRightMost(root_));
+    Node* last = getRightMost(root_);
+    return reverse_iterator((0 != deadCount_ && last != NULL && last->balance_.isDead()) ? prevNode(last) : last);
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::rend()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::rend()
 {
     return reverse_iterator(NULL);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reverse_iterator 
-MultiSet<Data>::rbegin() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::rbegin() const
 {
-    return const_reverse_iterator(getRightMost(root_));
+    Node* last = getRightMost(root_);
+    return const_reverse_iterator((0 != deadCount_ && last != NULL && last->balance_.isDead()) ? prevNode(last) : last);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reverse_iterator 
-MultiSet<Data>::rend() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::rend() const
 {
     return const_reverse_iterator(NULL);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator
-MultiSet<Data>::insert(const value_type& x)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator
+MultiSet<Data, Instrument, Balance, Augment>::insert(const value_type& x)
 {
-    return insertHelper(iterator(root_), x);
+    typename Instrument::Scope scope(*this, MULTISET_INSERT);
+    this->onTrace(MULTISET_TRACE_INSERT, x);
+    Node* node = allocateNode(x);
+    this->onAllocation();
+    return insertHelper(iterator(root_), node);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator
-MultiSet<Data>::insert(iterator it, const value_type& x)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator
+MultiSet<Data, Instrument, Balance, Augment>::insert(iterator it, const value_type& x)
 {
-    return insertHelper(it, x);    
+    typename Instrument::Scope scope(*this, MULTISET_INSERT);
+    this->onTrace(MULTISET_TRACE_INSERT, x);
+    Node* node = allocateNode(x);
+    this->onAllocation();
+    return insertHelper(it, node);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator
-MultiSet<Data>::insertHelper(iterator it, const value_type& x)
+/// Links the node of a handle from extract back in; nothing is allocated
+/// or copied unless the node is in the arena of another set. An empty handle inserts nothing and yields end().
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator
+MultiSet<Data, Instrument, Balance, Augment>::insert(node_type&& node)
 {
-    if (empty()) { root_ = new Node(x); return begin(); }
-    goUp(it, x);
-    goDownAndInsert(it, x);
-    balance(it); 
+    if (node.empty()) { return end(); }
+    typename Instrument::Scope scope(*this, MULTISET_INSERT);
+    this->onTrace(MULTISET_TRACE_INSERT, node.node_->data_);
+    if (node.arena_ != NULL && node.arena_ != arena_) {
+        Node* copy = allocateNode(node.node_->data_);
+        this->onAllocation();
+        node = node_type();
+        return insertHelper(iterator(root_), copy);
+    }
+    Node* linked = node.node_;
+    NodeArena<Node>::release(node.arena_);
+    node.node_ = NULL;
+    node.arena_ = NULL;
+    return insertHelper(iterator(root_), linked);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator
+MultiSet<Data, Instrument, Balance, Augment>::insertHelper(iterator it, Node* node)
+{
+    if (NULL == root_) {
+        root_ = node;
+        refreshAggregates(root_);
+        Balance::afterInsert(*this, root_);
+        return begin();
+    }
+    if (!it) { it = iterator(root_); }
+    goUp(it, node->data_);
+    goDownAndInsert(it, node);
+    refreshAggregates(it.getPtr());
+    Balance::afterInsert(*this, it.getPtr());
     return it;
 }
 
-template <typename Data>
+/// Climbs from the hint to the lowest ancestor whose subtree may hold x,
+/// i.e. whose bounds (the nearest ancestors it hangs right and left of)
+/// enclose x. A bound x falls outside of is itself the next candidate.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::goUp(iterator& it, const value_type& x)
-{
-    if (!it.parent() || x == *it) { return; }
-    const const_iterator temp = (x < *it) 
-                              ? it.firstLeftParent()
-                              : it.firstRightParent();
-    if (isRoot(temp)) { return; }
-    const bool isRightPlace = (x < *it) 
-                            ? (*temp < x) 
-                            : (*temp > x);
-    if (isRightPlace) { return; }
-    it.ptr_ = temp.ptr_;
-    goUp(it, x);
-}
-
-template <typename Data>
+MultiSet<Data, Instrument, Balance, Augment>::goUp(iterator& it, const value_type& x)
+{
+    while (it.parent()) {
+        const const_iterator lower = it.firstLeftParent();
+        const const_iterator upper = it.firstRightParent();
+        this->onComparison(2);
+        if (lower && x < *lower) {
+            it.ptr_ = lower.ptr_;
+        } else if (upper && *upper < x) {
+            it.ptr_ = upper.ptr_;
+        } else {
+            return;
+        }
+    }
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::goDownAndInsert(iterator& it, const value_type& x) 
+MultiSet<Data, Instrument, Balance, Augment>::goDownAndInsert(iterator& it, Node* node) 
 {
     if (!it) { return; }
+    const value_type& x = node->data_;
+    this->onComparison();
     if (it && x <= *it) {
-        if (!it.left()) { it.createLeft(x); return; }
-        return goDownAndInsert(it.goLeft(), x);
+        if (!it.left()) {
+            it.getPtr()->left_ = node;
+            node->parent_ = it.getPtr();
+            it.goLeft();
+            return;
+        }
+        return goDownAndInsert(it.goLeft(), node);
     }
+    this->onComparison();
     if (it && x >= *it) {
-        if (!it.right()) { it.createRight(x); return; }
-        return goDownAndInsert(it.goRight(), x);
+        if (!it.right()) {
+            it.getPtr()->right_ = node;
+            node->parent_ = it.getPtr();
+            it.goRight();
+            return;
+        }
+        return goDownAndInsert(it.goRight(), node);
     }
 }
 
-template <typename Data>
-void 
-MultiSet<Data>::balance(iterator& it)
-{
-    if (!it) { return; }
-    const int factor = it.balance();
-    if (factor > 1) {
-        iterator itLeft = it.left();
-        if (itLeft.balance() < 0) { rotateRight(itLeft); }
-        rotateLeft(it);
-        return;
-    } 
-    if (factor < -1) {
-        iterator itRight = it.right();
-        if (itRight.balance() > 0) { rotateLeft(itRight); }
-        rotateRight(it);
-        return;
-    }
-    balance(it.goParent()); 
-} 
-
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::rotateRight(iterator& it)
+MultiSet<Data, Instrument, Balance, Augment>::rotateRight(iterator& it)
 {
+    this->onRotation();
     iterator itParent = it.parent(), itRight = it.right();
     const bool isRightParent = it.isRightParent();
     it.setRight(itRight.left());
@@ -248,13 +437,18 @@ MultiSet<Data>::rotateRight(iterator& it)
         isRightParent ? itParent.setLeft(itRight)
                       : itParent.setRight(itRight);
     } else { root_ = itRight.getPtr(); }
+    Balance::update(it.getPtr());
+    Balance::update(itRight.getPtr());
+    updateAggregate(it.getPtr());
+    updateAggregate(itRight.getPtr());
     it = itRight;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::rotateLeft(iterator& it)
+MultiSet<Data, Instrument, Balance, Augment>::rotateLeft(iterator& it)
 {
+    this->onRotation();
     iterator itParent = it.parent(), itLeft = it.left();
     const bool isLeftParent = it.isLeftParent();
     it.setLeft(itLeft.right());
@@ -266,141 +460,784 @@ MultiSet<Data>::rotateLeft(iterator& it)
         isLeftParent ? itParent.setRight(itLeft)
                      : itParent.setLeft(itLeft);
     } else { root_ = itLeft.getPtr(); }
+    Balance::update(it.getPtr());
+    Balance::update(itLeft.getPtr());
+    updateAggregate(it.getPtr());
+    updateAggregate(itLeft.getPtr());
     it = itLeft;
 }
 
-template <typename Data>
+/// Lifts n above its parent; the entry point of the balance policies.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node*
+MultiSet<Data, Instrument, Balance, Augment>::rotateUp(Node* n)
+{
+    iterator it(n->parent_);
+    n == n->parent_->left_ ? rotateLeft(it) : rotateRight(it);
+    return n;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::replaceChild(Node* parent, Node* oldChild, Node* newChild)
+{
+    if (NULL == parent) { root_ = newChild; return; }
+    parent->left_ == oldChild ? parent->left_  = newChild
+                              : parent->right_ = newChild;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::aggregate_type
+MultiSet<Data, Instrument, Balance, Augment>::aggregateOf(const Node* n)
+{
+    return NULL == n ? Augment::identity() : n->aggregate_;
+}
+
+/// A lazily erased node still routes searches but no longer contributes.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::aggregate_type
+MultiSet<Data, Instrument, Balance, Augment>::liftOf(const Node* n)
+{
+    return n->balance_.isDead() ? Augment::identity() : Augment::lift(n->data_);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::updateAggregate(Node* n)
+{
+    updateAggregate(n, std::integral_constant<bool, Augment::ENABLED != 0>());
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::updateAggregate(Node* n, std::true_type)
+{
+    n->aggregate_ = Augment::combine(Augment::combine(aggregateOf(n->left_), liftOf(n)), aggregateOf(n->right_));
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::updateAggregate(Node*, std::false_type)
+{}
+
+/// Recomputes the aggregates from n up to the root after n's subtree
+/// gained or lost a node. Done before rebalancing, so that every rotation
+/// starts from correct children.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::refreshAggregates(Node* n)
+{
+    if (!Augment::ENABLED) { return; }
+    for (; n != NULL; n = n->parent_) { updateAggregate(n); }
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 template <typename InputIt>
 void 
-MultiSet<Data>::insert(InputIt first, InputIt last)
+MultiSet<Data, Instrument, Balance, Augment>::insert(InputIt first, InputIt last)
 {
     while (first != last) { insert(*first++); }
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::erase(iterator pos)
+MultiSet<Data, Instrument, Balance, Augment>::erase(iterator pos)
 {
     assert(pos != end());
-    Node* posNode = pos.getPtr();
-    Node* replaceNode = getRightMost(posNode->left_);
-    iterator posParent = pos.parent(); 
-    if (NULL == replaceNode) {
-        if (posParent) {
-            pos.isRightParent() ? posNode->parent_->left_   = posNode->right_
-                                : posNode->parent_->right_  = posNode->right_;
-            if (posNode->right_) { posNode->right_->parent_ = posNode->parent_; } 
-            delete posNode; 
-            balance(posParent);
-            return; 
-        }
-        Node* temp = root_; 
-        root_ = root_->right_; 
-        if (root_) { root_->parent_ = NULL; } 
-        delete temp; 
-        balance(posParent);
-        return; 
+    typename Instrument::Scope scope(*this, MULTISET_ERASE);
+    this->onTrace(MULTISET_TRACE_ERASE, *pos);
+    eraseNode(pos.getPtr());
+    compactIfNeeded();
+}
+
+/// In lazy mode the node is only marked dead: iterators to other elements
+/// stay valid and no rebalancing is done until the next compaction.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::eraseNode(Node* posNode)
+{
+    if (0 != compactThreshold_) {
+        posNode->balance_.setDead();
+        ++deadCount_;
+        refreshAggregates(posNode);
+        return;
     }
-    if (posParent) {
-        pos.isRightParent() ? posNode->parent_->left_  = replaceNode
-                            : posNode->parent_->right_ = replaceNode;
+    unlinkNode(posNode);
+    freeNode(posNode);
+    this->onFree();
+}
+
+/// Takes posNode out of the tree and rebalances; posNode itself is left
+/// untouched.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::unlinkNode(Node* posNode)
+{
+    if (posNode == finger_) { finger_ = NULL; }
+    if (relocation_ != NULL && posNode == relocation_->cursor_) { relocation_->cursor_ = predecessor(posNode); }
+    Node* parent;
+    Node* child;
+    bool isLeft;
+    typename Balance::Info removed;
+    if (posNode->left_ && posNode->right_) {
+        /// The predecessor takes the place (and the balance info) of posNode,
+        /// its own place is the one that gets unlinked.
+        Node* replaceNode = getRightMost(posNode->left_);
+        removed = replaceNode->balance_;
+        child = replaceNode->left_;
+        if (replaceNode == posNode->left_) {
+            parent = replaceNode;
+            isLeft = true;
+        } else {
+            parent = replaceNode->parent_;
+            isLeft = false;
+            parent->right_ = child;
+            if (child) { child->parent_ = parent; }
+            replaceNode->left_ = posNode->left_;
+            posNode->left_->parent_ = replaceNode;
+        }
+        replaceNode->right_ = posNode->right_;
+        posNode->right_->parent_ = replaceNode;
+        replaceNode->parent_ = posNode->parent_;
+        replaceNode->balance_ = posNode->balance_;
+        replaceChild(posNode->parent_, posNode, replaceNode);
+    } else {
+        child = posNode->left_ ? posNode->left_ : posNode->right_;
+        parent = posNode->parent_;
+        isLeft = parent && parent->left_ == posNode;
+        removed = posNode->balance_;
+        if (child) { child->parent_ = parent; }
+        replaceChild(parent, posNode, child);
     }
-    iterator(replaceNode).isRightParent() ? replaceNode->parent_->left_  = replaceNode->left_
-                                          : replaceNode->parent_->right_ = replaceNode->left_;
-    if (replaceNode->left_) { replaceNode->left_->parent_ = replaceNode->parent_; }
-    replaceNode->parent_ = posNode->parent_;
-    
-    replaceNode->right_ = posNode->right_;
-    if (posNode->right_) { posNode->right_->parent_ = replaceNode; }
-    
-    replaceNode->left_ = posNode->left_;
-    if (posNode->left_)  { posNode->left_->parent_  = replaceNode; }
-    
-    if (posNode == root_) { root_ = replaceNode; }
-    delete posNode;
-    balance(posParent);
-    
+    refreshAggregates(parent);
+    Balance::afterErase(*this, parent, child, isLeft, removed);
 }
 
-template <typename Data>
-typename MultiSet<Data>::size_type 
-MultiSet<Data>::erase(const key_type& k)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type 
+MultiSet<Data, Instrument, Balance, Augment>::erase(const key_type& k)
 {
-    return eraseRangeHelper(lower_bound(k), upper_bound(k));
+    typename Instrument::Scope scope(*this, MULTISET_ERASE);
+    this->onTrace(MULTISET_TRACE_ERASE_ALL, k);
+    const size_type counter = eraseRangeHelper(lower_bound(k), upper_bound(k), false);
+    compactIfNeeded();
+    return counter;
 }
 
-template <typename Data>
+/// Traced as one erase per element, so a replay needs no iterators.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::erase(iterator first, iterator last)
+MultiSet<Data, Instrument, Balance, Augment>::erase(iterator first, iterator last)
 {
-    eraseRangeHelper(first, last);
-    return void();
+    typename Instrument::Scope scope(*this, MULTISET_ERASE);
+    eraseRangeHelper(first, last, true);
+    compactIfNeeded();
 }
 
-template <typename Data>
-typename MultiSet<Data>::size_type 
-MultiSet<Data>::eraseRangeHelper(iterator first, iterator last)
+/// Unlinks the element at pos, also in lazy mode, and hands its node over
+/// without freeing it. Iterators to other elements stay valid.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::node_type
+MultiSet<Data, Instrument, Balance, Augment>::extract(iterator pos)
+{
+    assert(pos != end());
+    typename Instrument::Scope scope(*this, MULTISET_ERASE);
+    this->onTrace(MULTISET_TRACE_ERASE, *pos);
+    Node* node = pos.getPtr();
+    unlinkNode(node);
+    if (findBlock(node) != NULL) {
+        /// A block goes with its last node, so the handle gets one of its own.
+        Node* copy = new Node(node->data_);
+        this->onAllocation();
+        freeNode(node);
+        return node_type(copy, NULL);
+    }
+    node->parent_ = node->left_ = node->right_ = NULL;
+    node->balance_ = Balance::leafInfo();
+    return node_type(node, (arena_ != NULL && arena_->owns(node)) ? arena_ : NULL);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::node_type
+MultiSet<Data, Instrument, Balance, Augment>::extract(const key_type& k)
+{
+    const iterator pos = find(k);
+    return pos == end() ? node_type() : extract(pos);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type 
+MultiSet<Data, Instrument, Balance, Augment>::eraseRangeHelper(iterator first, iterator last, bool traceEach)
 {
     int counter = 0;
     for (iterator it = first; it != last;) {
         ++it;
-        erase(first);
+        if (traceEach) { this->onTrace(MULTISET_TRACE_ERASE, *first); }
+        eraseNode(first.getPtr());
         first = it;
         ++counter;
     }
+    this->onIteratorStep(counter);
     return counter;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::find(const key_type& key) const
+/// With isLazy erase only marks nodes dead, and the tree is compacted once
+/// compactThreshold dead nodes have piled up (never automatically when it
+/// is 0). Switching lazy mode off compacts right away.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::set_lazy_erase(bool isLazy, size_type compactThreshold)
+{
+    if (!isLazy) {
+        compact();
+        compactThreshold_ = 0;
+        return;
+    }
+    compactThreshold_ = (0 == compactThreshold) ? std::numeric_limits<size_type>::max() : compactThreshold;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::dead_count() const
+{
+    return deadCount_;
+}
+
+/// Frees the dead nodes and relinks the live ones into a perfectly
+/// balanced tree in O(n), without comparing or copying elements.
+/// Invalidates all iterators.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::compact()
+{
+    if (0 == deadCount_) { return; }
+    std::vector<Node*> nodes;
+    auto keepAll = [](const Data&) { return false; };
+    collectSurvivors(root_, nodes, keepAll);
+    relink(nodes);
+}
+
+/// Erases every element for which pred is true in one in-order pass. The
+/// survivors keep their nodes and are relinked into a perfectly balanced
+/// tree, so this is O(n) however many elements go, and lazily erased
+/// nodes are freed on the way. pred must not throw. Invalidates all
+/// iterators.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Predicate>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::remove_if(Predicate pred)
+{
+    typename Instrument::Scope scope(*this, MULTISET_ERASE);
+    std::vector<Node*> nodes;
+    const size_type removed = collectSurvivors(root_, nodes, pred);
+    relink(nodes);
+    return removed;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment, typename Predicate>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+erase_if(MultiSet<Data, Instrument, Balance, Augment>& ms, Predicate pred)
+{
+    return ms.remove_if(pred);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::compactIfNeeded()
+{
+    if (0 != compactThreshold_ && deadCount_ >= compactThreshold_) { compact(); }
+}
+
+/// Appends the surviving nodes in order, deletes the dead ones and those
+/// pred picks, and returns how many live elements were removed. A node is
+/// deleted only after its right child pointer has been read.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Predicate>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::collectSurvivors(Node* root, std::vector<Node*>& nodes, Predicate& pred)
+{
+    if (NULL == root) { return 0; }
+    size_type removed = collectSurvivors(root->left_, nodes, pred);
+    Node* right = root->right_;
+    const bool isRemoved = !root->balance_.isDead() && pred(const_cast<const Data&>(root->data_));
+    if (root->balance_.isDead() || isRemoved) {
+        freeNode(root);
+        this->onFree();
+        removed += isRemoved;
+    } else {
+        nodes.push_back(root);
+    }
+    return removed + collectSurvivors(right, nodes, pred);
+}
+
+/// Makes nodes (in order, all live) the whole tree, perfectly balanced.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::relink(std::vector<Node*>& nodes)
+{
+    int maxDepth = 0;
+    while ((uint64_t(2) << maxDepth) <= nodes.size()) { ++maxDepth; }
+    root_ = linkBalanced(nodes.data(), nodes.size(), 0, maxDepth);
+    if (root_ != NULL) { root_->parent_ = NULL; }
+    deadCount_ = 0;
+    finger_ = NULL;
+    if (relocation_ != NULL) { relocation_->cursor_ = NULL; }
+}
+
+/// Moves the nodes into one new contiguous block, in key order or in van
+/// Emde Boas order (every subtree of half the height is contiguous), at
+/// most maxNodes of them per call, and returns true once a pass is done.
+/// The call that starts a pass counts the nodes and, when isRebalanced,
+/// relinks them perfectly balanced first; VEB_LAYOUT always does, as it
+/// lays out a complete tree. Later calls continue the pass and ignore
+/// layout and isRebalanced. Elements inserted behind the pass keep their
+/// nodes. Iterators to moved nodes are invalidated.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::defragment(size_type maxNodes, DefragmentLayout layout, bool isRebalanced)
+{
+    if (NULL == relocation_ || !relocation_->isRunning_) { startDefragment(layout, isRebalanced); }
+    Relocation& state = *relocation_;
+    for (size_type visited = 0; visited < maxNodes; ++visited) {
+        Node* node = (NULL == state.cursor_) ? getLeftMost(root_) : successor(state.cursor_);
+        if (NULL == node) {
+            state.isRunning_ = false;
+            std::vector<char>().swap(state.isSlotUsed_);
+            if (0 == state.blocks_.back().live_) {
+                ::operator delete(state.blocks_.back().nodes_);
+                state.blocks_.pop_back();
+            }
+            return true;
+        }
+        state.cursor_ = node;
+        NodeBlock& target = state.blocks_.back();
+        if (findBlock(node) == &target) { continue; }
+        size_type slot = state.nextSlot_;
+        if (VEB_LAYOUT == state.layout_) {
+            const uint64_t index = heapIndex(node);
+            if (0 != (index >> state.height_)) { continue; }
+            slot = vebPosition(index, state.height_);
+            if (state.isSlotUsed_[slot]) { continue; }
+            state.isSlotUsed_[slot] = 1;
+        } else if (slot < target.capacity_) {
+            ++state.nextSlot_;
+        } else {
+            continue;
+        }
+        relocate(node, target.nodes_ + slot);
+    }
+    return false;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::startDefragment(DefragmentLayout layout, bool isRebalanced)
+{
+    if (NULL == relocation_) { relocation_ = new Relocation(); }
+    if (isRebalanced || VEB_LAYOUT == layout) {
+        std::vector<Node*> nodes;
+        auto keepAll = [](const Data&) { return false; };
+        collectSurvivors(root_, nodes, keepAll);
+        relink(nodes);
+    }
+    size_type count = 0;
+    for (Node* n = getLeftMost(root_); n != NULL; n = successor(n)) { ++count; }
+    int height = 0;
+    while ((uint64_t(1) << height) <= count) { ++height; }
+    const size_type capacity = (VEB_LAYOUT == layout) ? (size_type(1) << height) - 1 : count;
+    const NodeBlock target = { static_cast<Node*>(::operator new(capacity * sizeof(Node))), capacity, 0 };
+    relocation_->blocks_.push_back(target);
+    relocation_->isSlotUsed_.assign(VEB_LAYOUT == layout ? capacity : 0, 0);
+    relocation_->cursor_ = NULL;
+    relocation_->nextSlot_ = 0;
+    relocation_->height_ = height;
+    relocation_->layout_ = layout;
+    relocation_->isRunning_ = true;
+}
+
+/// Moves node into slot of the running pass's block and relinks it.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::relocate(Node* node, Node* slot)
+{
+    Node* moved = ::new (static_cast<void*>(slot)) Node(std::move(*node));
+    ++relocation_->blocks_.back().live_;
+    trackPooledNode(true);
+    replaceChild(moved->parent_, node, moved);
+    if (moved->left_) { moved->left_->parent_ = moved; }
+    if (moved->right_) { moved->right_->parent_ = moved; }
+    if (finger_ == node) { finger_ = moved; }
+    if (relocation_->cursor_ == node) { relocation_->cursor_ = moved; }
+    freeNode(node);
+}
+
+/// Switches where new nodes are allocated: operator new, an arena of 2 MB
+/// chunks, or such an arena on huge pages (see NodeArena). Returns false
+/// and changes nothing unless the set is empty; lazily erased nodes and
+/// defragment blocks still held are freed first.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::set_node_storage(NodeStorage storage)
+{
+    if (!empty()) { return false; }
+    clear();
+    NodeArena<Node>::release(arena_);
+    arena_ = NULL;
+    if (storage != HEAP_STORAGE) { arena_ = new NodeArena<Node>(HUGE_PAGE_STORAGE == storage); }
+    return true;
+}
+
+/// "heap" unless the arena has chunks; then how the last one was mapped.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const char*
+MultiSet<Data, Instrument, Balance, Augment>::node_storage_backing() const
+{
+    return NULL == arena_ ? "heap" : arena_->backing();
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node*
+MultiSet<Data, Instrument, Balance, Augment>::allocateNode(const value_type& x)
+{
+    if (NULL == arena_) { return new Node(x); }
+    void* slot = arena_->allocate();
+    try {
+        Node* node = ::new (slot) Node(x);
+        trackPooledNode(true);
+        return node;
+    } catch (...) {
+        arena_->deallocate(slot);
+        throw;
+    }
+}
+
+/// Frees a node that is out of the tree. Arena slots are recycled; a node
+/// in a block only ends its lifetime there, and the block goes with its
+/// last node unless it is still being filled.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::freeNode(Node* node)
+{
+    if (arena_ != NULL && arena_->owns(node)) {
+        node->~Node();
+        trackPooledNode(false);
+        arena_->deallocate(node);
+        return;
+    }
+    NodeBlock* block = findBlock(node);
+    if (NULL == block) {
+        delete node;
+        return;
+    }
+    node->~Node();
+    trackPooledNode(false);
+    std::vector<NodeBlock>& blocks = relocation_->blocks_;
+    const bool isTarget = relocation_->isRunning_ && block == &blocks.back();
+    if (0 == --block->live_ && !isTarget) {
+        ::operator delete(block->nodes_);
+        blocks.erase(blocks.begin() + (block - &blocks[0]));
+    }
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::NodeBlock*
+MultiSet<Data, Instrument, Balance, Augment>::findBlock(Node* node) const
+{
+    if (NULL == relocation_) { return NULL; }
+    const std::less<Node*> isLess = std::less<Node*>();
+    for (size_type i = 0; i < relocation_->blocks_.size(); ++i) {
+        NodeBlock& block = relocation_->blocks_[i];
+        if (!isLess(node, block.nodes_) && isLess(node, block.nodes_ + block.capacity_)) { return &block; }
+    }
+    return NULL;
+}
+
+/// Whether node lives in an arena or a block rather than on its own.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::isPooled(Node* node) const
+{
+    return (arena_ != NULL && arena_->owns(node)) || findBlock(node) != NULL;
+}
+
+/// Nodes not made by Node::operator new are counted here.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::trackPooledNode(bool isAllocated)
+{
+#ifdef MULTISET_TRACK_MEMORY
+    if (isAllocated) {
+        liveNodes_.fetch_add(1, std::memory_order_relaxed);
+        liveBytes_.fetch_add(sizeof(Node), std::memory_order_relaxed);
+    } else {
+        liveNodes_.fetch_sub(1, std::memory_order_relaxed);
+        liveBytes_.fetch_sub(sizeof(Node), std::memory_order_relaxed);
+    }
+#else
+    (void)isAllocated;
+#endif /// MULTISET_TRACK_MEMORY
+}
+
+/// Position of node in a complete tree numbered level by level from 1.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+uint64_t
+MultiSet<Data, Instrument, Balance, Augment>::heapIndex(Node* node)
+{
+    uint64_t path = 0;
+    int depth = 0;
+    for (; node->parent_ != NULL; node = node->parent_, ++depth) {
+        if (depth >= 63) { return std::numeric_limits<uint64_t>::max(); }
+        if (node->parent_->right_ == node) { path |= uint64_t(1) << depth; }
+    }
+    return (uint64_t(1) << depth) | path;
+}
+
+/// Position of heap index in the van Emde Boas layout of a complete tree
+/// of the given height: the top half of the levels first, then every
+/// bottom subtree, each laid out the same way.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::vebPosition(uint64_t heapIndex, int height)
+{
+    int depth = 0;
+    while ((heapIndex >> depth) > 1) { ++depth; }
+    uint64_t index = heapIndex - (uint64_t(1) << depth);
+    size_type position = 0;
+    while (height > 1) {
+        const int top = height / 2;
+        const int bottom = height - top;
+        if (depth < top) {
+            height = top;
+            continue;
+        }
+        const int below = depth - top;
+        position += ((size_type(1) << top) - 1) + (index >> below) * ((size_type(1) << bottom) - 1);
+        index &= (uint64_t(1) << below) - 1;
+        depth = below;
+        height = bottom;
+    }
+    return position;
+}
+
+/// Links nodes[0, count) (in order) into a perfectly balanced subtree and
+/// returns its root, whose parent is left for the caller to set.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node*
+MultiSet<Data, Instrument, Balance, Augment>::linkBalanced(Node** nodes, size_type count, int depth, int maxDepth)
+{
+    if (0 == count) { return NULL; }
+    const size_type leftCount = (count - 1) / 2;
+    Node* root = nodes[leftCount];
+    root->left_ = linkBalanced(nodes, leftCount, depth + 1, maxDepth);
+    root->right_ = linkBalanced(nodes + leftCount + 1, count - leftCount - 1, depth + 1, maxDepth);
+    if (root->left_) { root->left_->parent_ = root; }
+    if (root->right_) { root->right_->parent_ = root; }
+    root->balance_ = Balance::leafInfo();
+    Balance::afterBuild(root, depth, maxDepth);
+    updateAggregate(root);
+    return root;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::find(const key_type& key) const
 {
+    typename Instrument::Scope scope(*this, MULTISET_FIND);
+    this->onTrace(MULTISET_TRACE_FIND, key);
     iterator it = lower_bound(key);
+    this->onComparison();
     return (it == end() || *it != key) ? iterator(NULL) : it;
 }
 
-template <typename Data>
-typename MultiSet<Data>::size_type 
-MultiSet<Data>::count(const key_type& key) const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type 
+MultiSet<Data, Instrument, Balance, Augment>::count(const key_type& key) const
 {
+    typename Instrument::Scope scope(*this, MULTISET_COUNT);
+    this->onTrace(MULTISET_TRACE_COUNT, key);
     iterator it = lower_bound(key);
     int counter = 0;
     while (it != end() && key == *it) { ++it; ++counter; }
+    this->onComparison(counter + 1);
+    this->onIteratorStep(counter);
     return counter;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::lower_bound(const key_type& key) const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::lower_bound(const key_type& key) const
+{
+    typename Instrument::Scope scope(*this, MULTISET_LOWER_BOUND);
+    this->onTrace(MULTISET_TRACE_LOWER_BOUND, key);
+    const bool isFinger = isFingerEnabled_ && finger_ != NULL;
+    iterator it = boundHelper(iterator(isFinger ? fingerRoot(finger_, key) : root_), key);
+    if (0 != deadCount_ && it != end() && it.getPtr()->balance_.isDead()) { ++it; }
+    if (isFingerEnabled_ && it != end()) { finger_ = it.getPtr(); }
+    return it;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::find(const_iterator hint, const key_type& key) const
 {
-    return boundHelper(iterator(root_), key);
+    typename Instrument::Scope scope(*this, MULTISET_FIND);
+    this->onTrace(MULTISET_TRACE_FIND, key);
+    iterator it = lower_bound(hint, key);
+    this->onComparison();
+    return (it == end() || *it != key) ? iterator(NULL) : it;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::upper_bound(const key_type& key) const
+/// Finger search: with a hint d elements away from the answer only the
+/// O(log d) levels above the hint are climbed and searched again.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::lower_bound(const_iterator hint, const key_type& key) const
 {
+    if (hint == end()) { return lower_bound(key); }
+    typename Instrument::Scope scope(*this, MULTISET_LOWER_BOUND);
+    this->onTrace(MULTISET_TRACE_LOWER_BOUND, key);
+    iterator it = boundHelper(iterator(fingerRoot(hint.getPtr(), key)), key);
+    if (0 != deadCount_ && it != end() && it.getPtr()->balance_.isDead()) { ++it; }
+    return it;
+}
+
+/// With finger search on, every lower_bound (and so find, count, erase by
+/// key...) starts from the previous result. Lookups then write to the set,
+/// so concurrent readers need finger search off.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::set_finger_search(bool isEnabled)
+{
+    isFingerEnabled_ = isEnabled;
+    finger_ = NULL;
+}
+
+/// Lowest ancestor of hint whose subtree, together with the ancestor it
+/// hangs left of, holds the lower bound of key. Towards larger keys the
+/// climb stops below the first ancestor not less than key, towards smaller
+/// keys below the first ancestor less than key.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node*
+MultiSet<Data, Instrument, Balance, Augment>::fingerRoot(Node* hint, const key_type& key) const
+{
+    this->onComparison();
+    const bool isForward = hint->data_ < key;
+    Node* n = hint;
+    for (Node* p = n->parent_; p != NULL; n = p, p = p->parent_) {
+        if ((p->left_ == n) != isForward) { continue; }
+        this->onComparison();
+        if (isForward ? !(p->data_ < key) : p->data_ < key) { break; }
+    }
+    return n;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::upper_bound(const key_type& key) const
+{
+    typename Instrument::Scope scope(*this, MULTISET_UPPER_BOUND);
+    this->onTrace(MULTISET_TRACE_UPPER_BOUND, key);
     iterator it = lower_bound(key);
-    while (it != end() && key == *it) { ++it; }
+    size_type counter = 0;
+    while (it != end() && key == *it) { ++it; ++counter; }
+    this->onComparison(counter + 1);
+    this->onIteratorStep(counter);
     return it;
 }
 
-template <typename Data>
-std::pair<typename MultiSet<Data>::iterator, typename MultiSet<Data>::iterator> 
-MultiSet<Data>::equal_range(const key_type& k) const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+std::pair<typename MultiSet<Data, Instrument, Balance, Augment>::iterator, typename MultiSet<Data, Instrument, Balance, Augment>::iterator> 
+MultiSet<Data, Instrument, Balance, Augment>::equal_range(const key_type& k) const
 {
     return std::make_pair(lower_bound(k), upper_bound(k));
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator
-MultiSet<Data>::boundHelper(iterator root, const key_type& key) const
+/// Aggregate of all elements in [lo, hi] (that is, of the range
+/// [lower_bound(lo), upper_bound(hi))) in key order. Below the node where
+/// the searches for lo and hi split, each step adds a node and one whole
+/// subtree, so only two root-to-leaf paths are visited.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::aggregate_type
+MultiSet<Data, Instrument, Balance, Augment>::range_aggregate(const key_type& lo, const key_type& hi) const
+{
+    Node* split = root_;
+    while (split != NULL) {
+        this->onComparison(2);
+        if (split->data_ < lo) {
+            split = split->right_;
+        } else if (hi < split->data_) {
+            split = split->left_;
+        } else {
+            break;
+        }
+    }
+    if (NULL == split) { return Augment::identity(); }
+    aggregate_type leftPart = Augment::identity();
+    for (Node* n = split->left_; n != NULL;) {
+        this->onComparison();
+        if (n->data_ < lo) {
+            n = n->right_;
+        } else {
+            leftPart = Augment::combine(Augment::combine(liftOf(n), aggregateOf(n->right_)), leftPart);
+            n = n->left_;
+        }
+    }
+    aggregate_type rightPart = Augment::identity();
+    for (Node* n = split->right_; n != NULL;) {
+        this->onComparison();
+        if (hi < n->data_) {
+            n = n->left_;
+        } else {
+            rightPart = Augment::combine(rightPart, Augment::combine(aggregateOf(n->left_), liftOf(n)));
+            n = n->right_;
+        }
+    }
+    return Augment::combine(Augment::combine(leftPart, liftOf(split)), rightPart);
+}
+
+/// Calls f for every element in [lo, hi] in key order and returns f. One
+/// in-order walk over the parent links from the root: left subtrees of
+/// keys below lo and right subtrees of keys above hi are never entered,
+/// so besides the range itself only the two boundary paths are visited.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Function>
+Function
+MultiSet<Data, Instrument, Balance, Augment>::for_each_in_range(const key_type& lo, const key_type& hi, Function f) const
+{
+    typename Instrument::Scope scope(*this, MULTISET_RANGE_SCAN);
+    this->onTrace(MULTISET_TRACE_RANGE_SCAN, lo, hi);
+    Node* prev = NULL;
+    for (Node* n = root_; n != NULL;) {
+        Node* next = n->parent_;
+        const bool isEntering = prev == n->parent_;
+        if (isEntering || prev == n->left_) {
+            this->onComparison(2);
+            const bool isAboveLo = !isEntering || !(n->data_ < lo);
+            const bool isBelowHi = !(hi < n->data_);
+            if (isEntering && isAboveLo && n->left_) {
+                next = n->left_;
+            } else {
+                if (isAboveLo && isBelowHi && !n->balance_.isDead()) { f(const_cast<const Data&>(n->data_)); }
+                if (isBelowHi && n->right_) { next = n->right_; }
+            }
+        }
+        prev = n;
+        n = next;
+    }
+    return f;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator
+MultiSet<Data, Instrument, Balance, Augment>::boundHelper(iterator root, const key_type& key) const
 {
     if (!root) { return root; }
+    this->onComparison();
     if (key <= *root) { 
         if (root.left()) { return boundHelper(root.left(), key); }
         return root;
     } 
+    this->onComparison();
     if (key >= *root) { 
         if (root.right()) { return boundHelper(root.right(), key); }
         return ++root;
@@ -409,16 +1246,16 @@ MultiSet<Data>::boundHelper(iterator root, const key_type& key) const
     return root;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::isRoot(const const_iterator& temp) const
+MultiSet<Data, Instrument, Balance, Augment>::isRoot(const const_iterator& temp) const
 {
     return temp == const_iterator(root_);
 }
     
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::operator==(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator==(const MultiSet& rhv) const
 {
     const_iterator first1 = begin();
     const_iterator first2 = rhv.begin();
@@ -430,168 +1267,427 @@ MultiSet<Data>::operator==(const MultiSet& rhv) const
     return first1 == end() && first2 == rhv.end();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::operator!=(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator!=(const MultiSet& rhv) const
 {
     return !(*this == rhv);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::operator<(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator<(const MultiSet& rhv) const
 {
     const_iterator first1 = begin();
     const_iterator first2 = rhv.begin();
     while (first1 && first2) {
-        if (*first1 >= *first2) { return false; }
+        if (*first1 < *first2) { return true;  }
+        if (*first2 < *first1) { return false; }
         ++first1;
         ++first2;
     }
     return first1 == end() && first2 != rhv.end();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::operator<=(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator<=(const MultiSet& rhv) const
 {
     return !(rhv < *this);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool
-MultiSet<Data>::operator>(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator>(const MultiSet& rhv) const
 {
     return rhv < *this;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::operator>=(const MultiSet& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::operator>=(const MultiSet& rhv) const
 {
     return !(*this < rhv);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::preOrderIter(std::ostream& out) const
-{
-    std::stack<Node*> st;
-    Node* temp = root_;
-    st.push(root_);
-    while (!st.empty()) {
-        out << temp->data_ << ' ';
-        if (temp->right_) { st.push(temp->right_); }
-        if (temp->left_)  { 
-            temp = temp->left_; 
-            continue; 
-        }
-        temp = st.top(); 
-        st.pop(); 
-    }
+MultiSet<Data, Instrument, Balance, Augment>::preOrderIter(std::ostream& out) const
+{
+    visit_preorder([&out](const Data& x) { out << x << ' '; });
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::preOrderRec(std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::preOrderRec(std::ostream& out) const
 {
     preOrderHelper(root_, out);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::preOrderHelper(Node* root, std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::preOrderHelper(Node* root, std::ostream& out) const
 {
     if (NULL == root) { return; }
-    out << root->data_ << ' ';
+    if (!root->balance_.isDead()) { out << root->data_ << ' '; }
     preOrderHelper(root->left_, out);
     preOrderHelper(root->right_, out);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::inOrderIter(std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::inOrderIter(std::ostream& out) const
 {
     for (const_iterator it = begin(); it != end(); ++it) {
         out << *it << ' ';
     }
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::inOrderRec(std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::inOrderRec(std::ostream& out) const
 {
     inOrderHelper(root_, out);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::inOrderHelper(Node* root, std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::inOrderHelper(Node* root, std::ostream& out) const
 {
     if (NULL == root) { return; }
     inOrderHelper(root->left_, out);
-    out << root->data_ << ' ';
+    if (!root->balance_.isDead()) { out << root->data_ << ' '; }
     inOrderHelper(root->right_, out);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::postOrderIter(std::ostream& out) const
-{
-    std::stack<Node*> stk1, stk2;
-    stk1.push(root_);
-    Node* current;
-
-    while (!stk1.empty()) {
-        current = stk1.top();
-        stk1.pop();
-        stk2.push(current);
-        if (current->left_)  { stk1.push(current->left_);  }
-        if (current->right_) { stk1.push(current->right_); }
-    }
-
-    while (!stk2.empty()) {
-        current = stk2.top();
-        stk2.pop();
-        out << current->data_ << ' ';
-    }
+MultiSet<Data, Instrument, Balance, Augment>::postOrderIter(std::ostream& out) const
+{
+    visit_postorder([&out](const Data& x) { out << x << ' '; });
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::postOrderRec(std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::postOrderRec(std::ostream& out) const
 {
     postOrderHelper(root_, out);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::postOrderHelper(Node* root, std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::postOrderHelper(Node* root, std::ostream& out) const
 {
     if (NULL == root) { return; }
     postOrderHelper(root->left_, out);
     postOrderHelper(root->right_, out);
-    out << root->data_ << ' ';
+    if (!root->balance_.isDead()) { out << root->data_ << ' '; }
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::levelOrderIter(std::ostream& out) const
-{
-    std::queue<Node*> que;
-    que.push(root_);
-    while (!que.empty()) {
-        Node* temp = que.front();
-        out << temp->data_ << ' ';
-        if (temp->left_)  { que.push(temp->left_);  }
-        if (temp->right_) { que.push(temp->right_); }
-        que.pop();
+MultiSet<Data, Instrument, Balance, Augment>::levelOrderIter(std::ostream& out) const
+{
+    visit_levelorder([&out](const Data& x) { out << x << ' '; });
+}
+
+/// The visit_* functions call visitor(const Data&) for every element in
+/// the given order and return the visitor. They walk the parent links, so
+/// they neither allocate nor recurse.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Visitor>
+Visitor
+MultiSet<Data, Instrument, Balance, Augment>::visit_preorder(Visitor visitor) const
+{
+    walkHelper<PRE_ORDER>(visitor, 0);
+    return visitor;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Visitor>
+Visitor
+MultiSet<Data, Instrument, Balance, Augment>::visit_inorder(Visitor visitor) const
+{
+    walkHelper<IN_ORDER>(visitor, 0);
+    return visitor;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Visitor>
+Visitor
+MultiSet<Data, Instrument, Balance, Augment>::visit_postorder(Visitor visitor) const
+{
+    walkHelper<POST_ORDER>(visitor, 0);
+    return visitor;
+}
+
+/// Every level is a walk of its own that turns back at that depth, so a
+/// balanced tree is walked about twice in total.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Visitor>
+Visitor
+MultiSet<Data, Instrument, Balance, Augment>::visit_levelorder(Visitor visitor) const
+{
+    for (int level = 0; walkHelper<LEVEL_ORDER>(visitor, level); ++level) {}
+    return visitor;
+}
+
+/// Depth-first walk over the parent links: coming from the parent a node
+/// is entered, coming from the left child its right subtree is next, and
+/// otherwise the walk goes back up. For LEVEL_ORDER only the nodes at
+/// depth level are visited; returns whether there are any.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <int ORDER, typename Visitor>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::walkHelper(Visitor& visitor, int level) const
+{
+    bool isLevelReached = false;
+    int depth = 0;
+    Node* prev = NULL;
+    for (Node* n = root_; n != NULL;) {
+        const bool isVisible = !n->balance_.isDead();
+        Node* next = n->parent_;
+        if (prev == n->parent_) {
+            if (PRE_ORDER == ORDER && isVisible) { visitor(const_cast<const Data&>(n->data_)); }
+            if (LEVEL_ORDER == ORDER && depth == level) {
+                if (isVisible) { visitor(const_cast<const Data&>(n->data_)); }
+                isLevelReached = true;
+            } else if (n->left_) {
+                next = n->left_;
+            } else {
+                if (IN_ORDER == ORDER && isVisible) { visitor(const_cast<const Data&>(n->data_)); }
+                if (n->right_) { next = n->right_; }
+            }
+        } else if (prev == n->left_) {
+            if (IN_ORDER == ORDER && isVisible) { visitor(const_cast<const Data&>(n->data_)); }
+            if (n->right_) { next = n->right_; }
+        }
+        if (next == n->parent_) {
+            if (POST_ORDER == ORDER && isVisible) { visitor(const_cast<const Data&>(n->data_)); }
+            --depth;
+        } else {
+            ++depth;
+        }
+        prev = n;
+        n = next;
     }
+    return isLevelReached;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Function>
+void
+MultiSet<Data, Instrument, Balance, Augment>::parallel_for_each(Function f, size_type threads) const
+{
+    std::vector<Chunk> chunks;
+    threads = splitChunks(threads, chunks);
+    runParallel(chunks.size(), threads, [&](size_type i) {
+        const Chunk& chunk = chunks[i];
+        if (chunk.isSingle_) {
+            if (!chunk.root_->balance_.isDead()) { f(const_cast<const Data&>(chunk.root_->data_)); }
+            return;
+        }
+        forEachHelper(chunk.root_, f);
+    });
+}
+
+/// Same as the overload below with op as combine, so op must be
+/// associative and init an identity for it.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename T, typename BinaryOp>
+T
+MultiSet<Data, Instrument, Balance, Augment>::parallel_reduce(T init, BinaryOp op, size_type threads) const
+{
+    return parallel_reduce(init, op, op, threads);
+}
+
+/// Every chunk is folded with op starting from init, and the partial
+/// results are merged left to right with combine. The result equals the
+/// sequential in-order fold op(...op(op(init, x1), x2)..., xn) when init is
+/// an identity for combine and combine merges two folds as if one had gone
+/// on over the elements of the other; op itself may take (T, Data), as in
+/// counting.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename T, typename BinaryOp, typename CombineOp>
+T
+MultiSet<Data, Instrument, Balance, Augment>::parallel_reduce(T init, BinaryOp op, CombineOp combine, size_type threads) const
+{
+    std::vector<Chunk> chunks;
+    threads = splitChunks(threads, chunks);
+    std::vector<T> partials(chunks.size(), init);
+    runParallel(chunks.size(), threads, [&](size_type i) {
+        const Chunk& chunk = chunks[i];
+        if (chunk.isSingle_) {
+            if (!chunk.root_->balance_.isDead()) { partials[i] = op(partials[i], chunk.root_->data_); }
+            return;
+        }
+        reduceHelper(chunk.root_, partials[i], op);
+    });
+    T result = init;
+    for (size_type i = 0; i < partials.size(); ++i) { result = combine(result, partials[i]); }
+    return result;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::size_type
+MultiSet<Data, Instrument, Balance, Augment>::splitChunks(size_type threads, std::vector<Chunk>& chunks) const
+{
+    if (0 == threads) { threads = std::thread::hardware_concurrency(); }
+    if (0 == threads) { threads = 1; }
+    /// A few chunks per thread, so that threads finishing early pick up
+    /// the remaining work instead of idling.
+    int levels = 0;
+    while ((size_type(1) << levels) < threads * 4 && levels < 20) { ++levels; }
+    if (1 == threads) { levels = 0; }
+    splitHelper(root_, levels, chunks);
+    return std::min(threads, std::max<size_type>(chunks.size(), 1));
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::splitHelper(Node* root, int levels, std::vector<Chunk>& chunks) const
+{
+    if (NULL == root) { return; }
+    if (0 == levels) { chunks.push_back(Chunk(root, false)); return; }
+    splitHelper(root->left_, levels - 1, chunks);
+    chunks.push_back(Chunk(root, true));
+    splitHelper(root->right_, levels - 1, chunks);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Function>
+void
+MultiSet<Data, Instrument, Balance, Augment>::forEachHelper(Node* root, Function& f)
+{
+    if (NULL == root) { return; }
+    forEachHelper(root->left_, f);
+    if (!root->balance_.isDead()) { f(const_cast<const Data&>(root->data_)); }
+    forEachHelper(root->right_, f);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename T, typename BinaryOp>
+void
+MultiSet<Data, Instrument, Balance, Augment>::reduceHelper(Node* root, T& result, BinaryOp& op)
+{
+    if (NULL == root) { return; }
+    reduceHelper(root->left_, result, op);
+    if (!root->balance_.isDead()) { result = op(result, root->data_); }
+    reduceHelper(root->right_, result, op);
+}
+
+/// Runs body(0) ... body(tasks - 1) on the calling thread plus threads - 1
+/// workers. Tasks are claimed dynamically from a shared counter, and the
+/// first exception thrown by a task is rethrown to the caller.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+template <typename Body>
+void
+MultiSet<Data, Instrument, Balance, Augment>::runParallel(size_type tasks, size_type threads, Body body)
+{
+    std::atomic<size_type> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_type i = next++; i < tasks; i = next++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) { error = std::current_exception(); }
+                next = tasks;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_type i = 1; i < threads; ++i) { pool.push_back(std::thread(worker)); }
+    worker();
+    for (size_type i = 0; i < pool.size(); ++i) { pool[i].join(); }
+    if (error) { std::rethrow_exception(error); }
+}
+
+/// Snapshot for sets that no longer change; see FrozenMultiSet.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+FrozenMultiSet<Data>
+MultiSet<Data, Instrument, Balance, Augment>::freeze() const
+{
+    return FrozenMultiSet<Data>(begin(), size());
+}
+
+/// Binary format: magic, format version, element size, element count and
+/// then the elements in sorted order, all in host byte order.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::save(std::ostream& out) const
+{
+    MultiSetWriter writer(out);
+    writer.write(MULTI_SET_MAGIC, sizeof(MULTI_SET_MAGIC));
+    writer.writeValue<uint32_t>(MULTI_SET_FORMAT_VERSION);
+    writer.writeValue<uint32_t>(MultiSetSerializer<Data>::elementSize());
+    writer.writeValue<uint64_t>(size());
+    for (const_iterator it = begin(); it != end(); ++it) {
+        MultiSetSerializer<Data>::write(writer, *it);
+    }
+    return writer.flush();
+}
+
+/// Replaces the contents with a set written by save. The elements are
+/// already sorted, so the tree is rebuilt perfectly balanced in O(n)
+/// without comparing them, into the set's node storage. On failure the set
+/// is left empty; an exception from reading an element propagates after
+/// the nodes built so far are freed.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::load(std::istream& in)
+{
+    clear();
+    MultiSetReader reader(in);
+    char magic[sizeof(MULTI_SET_MAGIC)];
+    reader.read(magic, sizeof(magic));
+    const uint32_t version = reader.readValue<uint32_t>();
+    const uint32_t elementSize = reader.readValue<uint32_t>();
+    const uint64_t count = reader.readValue<uint64_t>();
+    if (!reader.good() || 0 != std::memcmp(magic, MULTI_SET_MAGIC, sizeof(magic))) { return false; }
+    if (version != MULTI_SET_FORMAT_VERSION) { return false; }
+    if (elementSize != MultiSetSerializer<Data>::elementSize()) { return false; }
+    int maxDepth = 0;
+    while ((uint64_t(2) << maxDepth) <= count) { ++maxDepth; }
+    root_ = loadHelper(reader, count, 0, maxDepth);
+    if (!reader.good()) { clear(); return false; }
+    return true;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node*
+MultiSet<Data, Instrument, Balance, Augment>::loadHelper(MultiSetReader& in, uint64_t count, int depth, int maxDepth)
+{
+    if (0 == count || !in.good()) { return NULL; }
+    const uint64_t leftCount = (count - 1) / 2;
+    Node* left = loadHelper(in, leftCount, depth + 1, maxDepth);
+    Node* root = NULL;
+    try {
+        root = allocateNode(MultiSetSerializer<Data>::read(in));
+    } catch (...) {
+        clearHelper(left);
+        throw;
+    }
+    this->onAllocation();
+    root->left_ = left;
+    if (left) { left->parent_ = root; }
+    try {
+        root->right_ = loadHelper(in, count - 1 - leftCount, depth + 1, maxDepth);
+    } catch (...) {
+        clearHelper(root);
+        throw;
+    }
+    if (root->right_) { root->right_->parent_ = root; }
+    Balance::afterBuild(root, depth, maxDepth);
+    updateAggregate(root);
+    return root;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::outputTree(Node* ptr, std::ostream& out, const int totalSpaces) const
+MultiSet<Data, Instrument, Balance, Augment>::outputTree(Node* ptr, std::ostream& out, const int totalSpaces) const
 {
     if (NULL == ptr) { return; }
     outputTree(ptr->right_, out, totalSpaces + 5);
@@ -599,17 +1695,17 @@ MultiSet<Data>::outputTree(Node* ptr, std::ostream& out, const int totalSpaces)
     outputTree(ptr->left_, out, totalSpaces + 5);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::print(std::ostream& out) const
+MultiSet<Data, Instrument, Balance, Augment>::print(std::ostream& out) const
 {
     inOrderIter(out);
     out << std::endl;
 }
 
-template <typename Data>
-typename MultiSet<Data>::Node* 
-MultiSet<Data>::getRightMost(Node* rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::getRightMost(Node* rhv)
 {
     if (NULL == rhv) { return rhv; }
     while (rhv->right_ != NULL) { rhv = rhv->right_; }
@@ -617,226 +1713,234 @@ MultiSet<Data>::getRightMost(Node* rhv)
 }
 
 
-template <typename Data>
-typename MultiSet<Data>::Node* 
-MultiSet<Data>::getLeftMost(Node* rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::getLeftMost(Node* rhv)
 {
     if (NULL == rhv) { return rhv; }
     while (rhv->left_ != NULL) { rhv = rhv->left_; }
     return rhv;
 }
 
+/// In-order neighbours, dead nodes included.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::successor(Node* rhv)
+{
+    if (rhv->right_ != NULL) { return getLeftMost(rhv->right_); }
+    while (rhv->parent_ != NULL && rhv->parent_->right_ == rhv) { rhv = rhv->parent_; }
+    return rhv->parent_;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::predecessor(Node* rhv)
+{
+    if (rhv->left_ != NULL) { return getRightMost(rhv->left_); }
+    while (rhv->parent_ != NULL && rhv->parent_->left_ == rhv) { rhv = rhv->parent_; }
+    return rhv->parent_;
+}
+
+/// In-order neighbours, skipping nodes erased lazily.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::nextNode(Node* rhv)
+{
+    do { rhv = successor(rhv); } while (rhv != NULL && rhv->balance_.isDead());
+    return rhv;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::prevNode(Node* rhv)
+{
+    do { rhv = predecessor(rhv); } while (rhv != NULL && rhv->balance_.isDead());
+    return rhv;
+}
+
 /// const_iterator
 
-template <typename Data>
-MultiSet<Data>::const_iterator::const_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::const_iterator()
     : ptr_(NULL)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_iterator::const_iterator(Node* ptr)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::const_iterator(Node* ptr)
     : ptr_(ptr)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_iterator::const_iterator(const const_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::const_iterator(const const_iterator& rhv)
     : ptr_(rhv.ptr_)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_iterator::~const_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::~const_iterator()
 {
     destroy();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::const_iterator::destroy()
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::destroy()
 {
     ptr_ = NULL;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_iterator& 
-MultiSet<Data>::const_iterator::operator=(const const_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator=(const const_iterator& rhv)
 {
     ptr_ = rhv.ptr_;
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reference
-MultiSet<Data>::const_iterator::operator*() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reference
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator*() const
 {
     return ptr_->data_;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::value_type*
-MultiSet<Data>::const_iterator::operator->() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::value_type*
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator->() const
 {
     return &ptr_->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::operator++()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator++()
 {
-    if (NULL == ptr_->right_) { 
-        while (isLeftParent()) {
-            goParent();
-        }
-        goParent();
-        return *this;
-    }
-    ptr_ = getLeftMost(ptr_->right_);
+    ptr_ = nextNode(ptr_);
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::operator++(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator++(int)
 {
     Node* temp = ptr_;
-    if (NULL == ptr_->right_) { 
-        while (isLeftParent()) {
-            goParent();
-        }
-        goParent();
-        return const_iterator(temp);
-    }
-    ptr_ = getLeftMost(ptr_->right_);
+    ptr_ = nextNode(temp);
     return const_iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::operator--()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator--()
 {
-    if (NULL == ptr_->left_) { 
-        while (isRightParent()) {
-            goParent();
-        }
-        goParent();
-        return *this;
-    }
-    ptr_ = getRightMost(ptr_->left_);
+    ptr_ = prevNode(ptr_);
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::operator--(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator--(int)
 {
     Node* temp = ptr_;
-    if (NULL == ptr_->left_) { 
-        while (isRightParent()) {
-            goParent();
-        }
-        goParent();
-        return const_iterator(temp);
-    }
-    ptr_ = getRightMost(ptr_->left_);
+    ptr_ = prevNode(temp);
     return const_iterator(temp);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool
-MultiSet<Data>::const_iterator::isLeftParent() const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::isLeftParent() const
 {
     return ptr_->parent_ != NULL && ptr_->parent_->right_ == ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool
-MultiSet<Data>::const_iterator::isRightParent() const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::isRightParent() const
 {
     return ptr_->parent_ != NULL && ptr_->parent_->left_ == ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_iterator::operator==(const const_iterator& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator==(const const_iterator& rhv) const
 {
     return ptr_ == rhv.ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_iterator::operator!=(const const_iterator& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator!=(const const_iterator& rhv) const
 {
     return !(*this == rhv);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_iterator::operator!() const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator!() const
 {
     return NULL == ptr_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::Node* 
-MultiSet<Data>::const_iterator::getPtr() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::getPtr() const
 {
     return ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::const_iterator::setPtr(Node* temp)
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::setPtr(Node* temp)
 {
     ptr_ = temp;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::parent() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::parent() const
 {
     return const_iterator(ptr_->parent_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::left() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::left() const
 {
     return const_iterator(ptr_->left_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::right() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::right() const
 {
     return const_iterator(ptr_->right_);
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_iterator& 
-MultiSet<Data>::const_iterator::goParent()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::goParent()
 {
     ptr_ = ptr_->parent_;
     return *this;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_iterator& 
-MultiSet<Data>::const_iterator::goLeft()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::goLeft()
 {
     ptr_ = ptr_->left_;
     return *this;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_iterator& 
-MultiSet<Data>::const_iterator::goRight()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::goRight()
 {
     ptr_ = ptr_->right_;
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::firstLeftParent() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::firstLeftParent() const
 {
     if (!this->parent()) { return const_iterator(NULL); }
     const_iterator p = this->parent();
@@ -844,9 +1948,9 @@ MultiSet<Data>::const_iterator::firstLeftParent() const
     return p.firstLeftParent(); 
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_iterator 
-MultiSet<Data>::const_iterator::firstRightParent() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::firstRightParent() const
 {
     if (!this->parent()) { return const_iterator(NULL); }
     const_iterator p = this->parent();
@@ -854,51 +1958,37 @@ MultiSet<Data>::const_iterator::firstRightParent() const
     return p.firstRightParent(); 
 }
 
-template <typename Data>
-void 
-MultiSet<Data>::const_iterator::createLeft(const value_type& x)
-{
-    ptr_->left_ = new Node(x, ptr_);
-}
-
-template <typename Data>
-void 
-MultiSet<Data>::const_iterator::createRight(const value_type& x)
-{
-    ptr_->right_ = new Node(x, ptr_);
-}
-
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::const_iterator::setParent(const_iterator it)
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::setParent(const_iterator it)
 {
     ptr_->parent_ = it.getPtr();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::const_iterator::setLeft(const_iterator it)
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::setLeft(const_iterator it)
 {
     ptr_->left_ = it.getPtr();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void
-MultiSet<Data>::const_iterator::setRight(const_iterator it)
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::setRight(const_iterator it)
 {
     ptr_->right_ = it.getPtr();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 int 
-MultiSet<Data>::const_iterator::balance() const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::balance() const
 {
     return left().depth() - right().depth();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 int
-MultiSet<Data>::const_iterator::depth() const
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::depth() const
 {
     if (NULL == ptr_) { return 0; }
     const int leftDepth = left().depth();
@@ -906,162 +1996,134 @@ MultiSet<Data>::const_iterator::depth() const
     return std::max(leftDepth, rightDepth) + 1;
 }
 
-template <typename Data>
-MultiSet<Data>::const_iterator::operator bool() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_iterator::operator bool() const
 {
     return NULL != ptr_;
 }
 
 /// iterator
 
-template <typename Data>
-MultiSet<Data>::iterator::iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::iterator::iterator()
     : const_iterator()
 {}
 
-template <typename Data>
-MultiSet<Data>::iterator::iterator(Node* ptr)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::iterator::iterator(Node* ptr)
     : const_iterator(ptr)
 {}
 
-template <typename Data>
-MultiSet<Data>::iterator::iterator(const iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::iterator::iterator(const iterator& rhv)
     : const_iterator(rhv)
 {}
 
-template <typename Data>
-MultiSet<Data>::iterator::~iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::iterator::~iterator()
 {
     this->destroy();
 }
 
-template <typename Data>
-const typename MultiSet<Data>::iterator& 
-MultiSet<Data>::iterator::operator=(const iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator=(const iterator& rhv)
 {
     this->setPtr(rhv.getPtr());
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::reference 
-MultiSet<Data>::iterator::operator*()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reference 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator*()
 {
     return this->getPtr()->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::value_type*
-MultiSet<Data>::iterator::operator->()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::value_type*
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator->()
 {
     return &this->getPtr()->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::operator++()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator++()
 {
-    if (NULL == this->getPtr()->right_) { 
-        while (this->isLeftParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return *this;
-    }
-    this->setPtr(getLeftMost(this->getPtr()->right_));
+    this->setPtr(nextNode(this->getPtr()));
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::operator++(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator++(int)
 {
     Node* temp = this->getPtr();
-    if (NULL == temp->right_) { 
-        while (this->isLeftParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return iterator(temp);
-    }
-    this->setPtr(getLeftMost(this->getPtr()->right_));
+    this->setPtr(nextNode(temp));
     return iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::operator--()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator--()
 {
-    if (NULL == this->getPtr()->left_) { 
-        while (this->isRightParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return *this;
-    }
-    this->setPtr(getRightMost(this->getPtr()->left_));
+    this->setPtr(prevNode(this->getPtr()));
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::operator--(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::operator--(int)
 {
     Node* temp = this->getPtr();
-    if (NULL == this->getPtr()->left_) { 
-        while (this->isRightParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return iterator(temp);
-    }
-    this->setPtr(getRightMost(this->getPtr()->left_));
+    this->setPtr(prevNode(temp));
     return iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::parent()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::parent()
 {
     Node* temp = this->getPtr();
     return NULL == temp ? iterator(temp) : iterator(temp->parent_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::left()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::left()
 {
     Node* temp = this->getPtr();
     return NULL == temp ? iterator(temp) : iterator(temp->left_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator 
-MultiSet<Data>::iterator::right()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::right()
 {
     Node* temp = this->getPtr();
     return NULL == temp ? iterator(temp) : iterator(temp->right_);
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator& 
-MultiSet<Data>::iterator::goParent()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::goParent()
 {
     const_iterator::goParent();
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator& 
-MultiSet<Data>::iterator::goLeft()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::iterator::goLeft()
 {
     const_iterator::goLeft();
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::iterator&
-MultiSet<Data>::iterator::goRight()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::iterator&
+MultiSet<Data, Instrument, Balance, Augment>::iterator::goRight()
 {
     const_iterator::goRight();
     return *this;
@@ -1069,155 +2131,134 @@ MultiSet<Data>::iterator::goRight()
 
 /// const_reverse_iterator
 
-template <typename Data>
-MultiSet<Data>::const_reverse_iterator::const_reverse_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::const_reverse_iterator()
     : ptr_(NULL)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_reverse_iterator::const_reverse_iterator(Node* ptr)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::const_reverse_iterator(Node* ptr)
     : ptr_(ptr)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_reverse_iterator::const_reverse_iterator(const const_reverse_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::const_reverse_iterator(const const_reverse_iterator& rhv)
     : ptr_(rhv.ptr_)
 {}
 
-template <typename Data>
-MultiSet<Data>::const_reverse_iterator::~const_reverse_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::~const_reverse_iterator()
 {
     destroy();
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::const_reverse_iterator::destroy()
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::destroy()
 {
     ptr_ = NULL;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_reverse_iterator& 
-MultiSet<Data>::const_reverse_iterator::operator=(const const_reverse_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator=(const const_reverse_iterator& rhv)
 {
     ptr_ = rhv.ptr_;
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reference
-MultiSet<Data>::const_reverse_iterator::operator*() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reference
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator*() const
 {
     return ptr_->data_;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::value_type*
-MultiSet<Data>::const_reverse_iterator::operator->() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::value_type*
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator->() const
 {
     return &ptr_->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reverse_iterator 
-MultiSet<Data>::const_reverse_iterator::operator++()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator++()
 {
-    if (NULL == ptr_->left_) { 
-        while (isRightParent()) {
-            goParent();
-        }
-        goParent();
-        return *this;
-    }
-    ptr_ = getRightMost(ptr_->left_);
+    ptr_ = prevNode(ptr_);
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reverse_iterator 
-MultiSet<Data>::const_reverse_iterator::operator++(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator++(int)
 {
     Node* temp = ptr_;
-    if (NULL == ptr_->right_) { 
-        while (isLeftParent()) {
-            goParent();
-        }
-        goParent();
-        return const_reverse_iterator(temp);
-    }
-    ptr_ = getLeftMost(ptr_->right_);
+    ptr_ = prevNode(temp);
     return const_reverse_iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::const_reverse_iterator 
-MultiSet<Data>::const_reverse_iterator::operator--(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator--(int)
 {
     Node* temp = ptr_;
-    if (NULL == ptr_->right_) { 
-        while (isLeftParent()) {
-            goParent();
-        }
-        goParent();
-        return const_reverse_iterator(temp);
-    }
-    ptr_ = getLeftMost(ptr_->right_);
+    ptr_ = nextNode(temp);
     return const_reverse_iterator(temp);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool
-MultiSet<Data>::const_reverse_iterator::isLeftParent() const
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::isLeftParent() const
 {
     return ptr_->parent_ != NULL && ptr_->parent_->right_ == ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool
-MultiSet<Data>::const_reverse_iterator::isRightParent() const
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::isRightParent() const
 {
     return ptr_->parent_ != NULL && ptr_->parent_->left_ == ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_reverse_iterator::operator==(const const_reverse_iterator& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator==(const const_reverse_iterator& rhv) const
 {
     return ptr_ == rhv.ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_reverse_iterator::operator!=(const const_reverse_iterator& rhv) const
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator!=(const const_reverse_iterator& rhv) const
 {
     return !(*this == rhv);
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 bool 
-MultiSet<Data>::const_reverse_iterator::operator!() const
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::operator!() const
 {
     return NULL == ptr_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::Node* 
-MultiSet<Data>::const_reverse_iterator::getPtr() const
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::Node* 
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::getPtr() const
 {
     return ptr_;
 }
 
-template <typename Data>
+template <typename Data, typename Instrument, typename Balance, typename Augment>
 void 
-MultiSet<Data>::const_reverse_iterator::setPtr(Node* temp)
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::setPtr(Node* temp)
 {
     ptr_ = temp;
 }
 
-template <typename Data>
-const typename MultiSet<Data>::const_reverse_iterator&
-MultiSet<Data>::const_reverse_iterator::goParent()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator&
+MultiSet<Data, Instrument, Balance, Augment>::const_reverse_iterator::goParent()
 {
     ptr_ = ptr_->parent_;
     return *this;
@@ -1225,116 +2266,164 @@ MultiSet<Data>::const_reverse_iterator::goParent()
 
 /// reverse_iterator
 
-template <typename Data>
-MultiSet<Data>::reverse_iterator::reverse_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::reverse_iterator()
     : const_reverse_iterator()
 {}
 
-template <typename Data>
-MultiSet<Data>::reverse_iterator::reverse_iterator(Node* ptr)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::reverse_iterator(Node* ptr)
     : const_reverse_iterator(ptr)
 {}
 
-template <typename Data>
-MultiSet<Data>::reverse_iterator::reverse_iterator(const reverse_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::reverse_iterator(const reverse_iterator& rhv)
     : const_reverse_iterator(rhv)
 {}
 
-template <typename Data>
-MultiSet<Data>::reverse_iterator::~reverse_iterator()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::~reverse_iterator()
 {
     this->destroy();
 }
 
-template <typename Data>
-const typename MultiSet<Data>::reverse_iterator& 
-MultiSet<Data>::reverse_iterator::operator=(const reverse_iterator& rhv)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+const typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator=(const reverse_iterator& rhv)
 {
     this->setPtr(rhv.getPtr());
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::reference 
-MultiSet<Data>::reverse_iterator::operator*()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reference 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator*()
 {
     return this->getPtr()->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::value_type*
-MultiSet<Data>::reverse_iterator::operator->()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::value_type*
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator->()
 {
     return &this->getPtr()->data_;
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::reverse_iterator::operator++()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator++()
 {
-    if (NULL == this->getPtr()->left_) { 
-        while (this->isRightParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return *this;
-    }
-    this->setPtr(getRightMost(this->getPtr()->left_));
+    this->setPtr(prevNode(this->getPtr()));
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::reverse_iterator::operator++(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator++(int)
 {
     Node* temp = this->getPtr();
-    if (NULL == this->getPtr()->left_) { 
-        while (this->isRightParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return reverse_iterator(temp);
-    }
-    this->setPtr(getRightMost(this->getPtr()->left_));
+    this->setPtr(prevNode(temp));
     return reverse_iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::reverse_iterator::operator--()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator--()
 {
-    if (NULL == this->getPtr()->right_) { 
-        while (this->isLeftParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return *this;
-    }
-    this->setPtr(getLeftMost(this->getPtr()->right_));
+    this->setPtr(nextNode(this->getPtr()));
     return *this;
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator 
-MultiSet<Data>::reverse_iterator::operator--(int)
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::operator--(int)
 {
     Node* temp = this->getPtr();
-    if (NULL == temp->right_) { 
-        while (this->isLeftParent()) {
-            this->goParent();
-        }
-        this->goParent();
-        return reverse_iterator(temp);
-    }
-    this->setPtr(getLeftMost(this->getPtr()->right_));
+    this->setPtr(nextNode(temp));
     return reverse_iterator(temp);
 }
 
-template <typename Data>
-typename MultiSet<Data>::reverse_iterator& 
-MultiSet<Data>::reverse_iterator::goParent()
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator& 
+MultiSet<Data, Instrument, Balance, Augment>::reverse_iterator::goParent()
 {
     const_reverse_iterator::goParent();
     return *this;
 }
 
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::node_type::node_type()
+    : node_(NULL), arena_(NULL)
+{}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::node_type::node_type(Node* node, NodeArena<Node>* arena)
+    : node_(node), arena_(arena)
+{
+    if (arena_ != NULL) { arena_->retain(); }
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::node_type::node_type(node_type&& rhv)
+    : node_(rhv.node_), arena_(rhv.arena_)
+{
+    rhv.node_ = NULL;
+    rhv.arena_ = NULL;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::node_type::~node_type()
+{
+    destroy();
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::node_type&
+MultiSet<Data, Instrument, Balance, Augment>::node_type::operator=(node_type&& rhv)
+{
+    if (this != &rhv) {
+        destroy();
+        node_ = rhv.node_;
+        arena_ = rhv.arena_;
+        rhv.node_ = NULL;
+        rhv.arena_ = NULL;
+    }
+    return *this;
+}
+
+/// Frees the node where it came from and lets go of its arena.
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+void
+MultiSet<Data, Instrument, Balance, Augment>::node_type::destroy()
+{
+    if (NULL == arena_) {
+        delete node_;
+        return;
+    }
+    node_->~Node();
+    trackPooledNode(false);
+    arena_->deallocate(node_);
+    NodeArena<Node>::release(arena_);
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+bool
+MultiSet<Data, Instrument, Balance, Augment>::node_type::empty() const
+{
+    return NULL == node_;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+MultiSet<Data, Instrument, Balance, Augment>::node_type::operator bool() const
+{
+    return NULL != node_;
+}
+
+template <typename Data, typename Instrument, typename Balance, typename Augment>
+typename MultiSet<Data, Instrument, Balance, Augment>::value_type&
+MultiSet<Data, Instrument, Balance, Augment>::node_type::value() const
+{
+    assert(node_ != NULL);
+    return node_->data_;
+}
+
@@ -0,0 +1,142 @@
+#include "headers/NodeArena.hpp"
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <stdint.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+template <typename T>
+NodeArena<T>::NodeArena(bool isHugePages)
+    : free_(NULL)
+    , next_(NULL)
+    , end_(NULL)
+    , isHugePages_(isHugePages)
+    , backing_("heap")
+    , users_(1)
+{}
+
+template <typename T>
+NodeArena<T>::~NodeArena()
+{
+    for (std::size_t i = 0; i < chunks_.size(); ++i) { releaseChunk(chunks_[i]); }
+}
+
+template <typename T>
+void*
+NodeArena<T>::allocate()
+{
+    if (free_ != NULL) {
+        FreeSlot* slot = free_;
+        free_ = slot->next_;
+        return slot;
+    }
+    if (next_ == end_) {
+        char* chunk = allocateChunk();
+        chunks_.insert(std::upper_bound(chunks_.begin(), chunks_.end(), chunk, std::less<char*>()), chunk);
+        next_ = chunk;
+        end_ = chunk + CHUNK_SIZE / SLOT_SIZE * SLOT_SIZE;
+    }
+    void* slot = next_;
+    next_ += SLOT_SIZE;
+    return slot;
+}
+
+template <typename T>
+void
+NodeArena<T>::deallocate(void* slot)
+{
+    FreeSlot* freed = static_cast<FreeSlot*>(slot);
+    freed->next_ = free_;
+    free_ = freed;
+}
+
+template <typename T>
+bool
+NodeArena<T>::owns(const void* slot) const
+{
+    char* const address = static_cast<char*>(const_cast<void*>(slot));
+    const std::vector<char*>::const_iterator it
+        = std::upper_bound(chunks_.begin(), chunks_.end(), address, std::less<char*>());
+    return it != chunks_.begin() && std::less<char*>()(address, *(it - 1) + CHUNK_SIZE);
+}
+
+template <typename T>
+bool
+NodeArena<T>::is_huge_pages() const
+{
+    return isHugePages_;
+}
+
+template <typename T>
+const char*
+NodeArena<T>::backing() const
+{
+    return backing_;
+}
+
+template <typename T>
+std::size_t
+NodeArena<T>::chunk_count() const
+{
+    return chunks_.size();
+}
+
+template <typename T>
+void
+NodeArena<T>::retain()
+{
+    ++users_;
+}
+
+/// NULL is ignored.
+template <typename T>
+void
+NodeArena<T>::release(NodeArena* arena)
+{
+    if (arena != NULL && 0 == --arena->users_) { delete arena; }
+}
+
+/// Reserved huge pages are tried first. Without them twice the chunk size
+/// is mapped and trimmed to one aligned chunk, which is what the kernel
+/// needs to back it with a transparent huge page.
+template <typename T>
+char*
+NodeArena<T>::allocateChunk()
+{
+#if defined(__linux__)
+    if (isHugePages_) {
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* chunk = ::mmap(NULL, CHUNK_SIZE, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (chunk != MAP_FAILED) {
+            backing_ = "hugetlb";
+            return static_cast<char*>(chunk);
+        }
+        void* mapped = ::mmap(NULL, 2 * CHUNK_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (MAP_FAILED == mapped) { throw std::bad_alloc(); }
+        char* const raw = static_cast<char*>(mapped);
+        char* const aligned = raw + (-reinterpret_cast<uintptr_t>(raw) & (CHUNK_SIZE - 1));
+        if (aligned != raw) { ::munmap(raw, aligned - raw); }
+        ::munmap(aligned + CHUNK_SIZE, raw + CHUNK_SIZE - aligned);
+        ::madvise(aligned, CHUNK_SIZE, MADV_HUGEPAGE);
+        backing_ = "madvise";
+        return aligned;
+    }
+#endif /// __linux__
+    return static_cast<char*>(::operator new(CHUNK_SIZE));
+}
+
+template <typename T>
+void
+NodeArena<T>::releaseChunk(char* chunk)
+{
+#if defined(__linux__)
+    if (isHugePages_) {
+        ::munmap(chunk, CHUNK_SIZE);
+        return;
+    }
+#endif /// __linux__
+    ::operator delete(chunk);
+}
+
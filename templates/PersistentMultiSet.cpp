@@ -0,0 +1,443 @@
+#include "headers/PersistentMultiSet.hpp"
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char PERSISTENT_MULTI_SET_MAGIC[8] = { 'M', 'S', 'E', 'T', 'P', 'M', 'A', 'P' };
+static const uint32_t PERSISTENT_MULTI_SET_VERSION = 1;
+static const std::size_t PERSISTENT_MULTI_SET_HEADER_BYTES = 64;
+static const uint64_t PERSISTENT_MULTI_SET_INITIAL_CAPACITY = 1024;
+
+template <typename Data, typename Offset>
+PersistentMultiSet<Data, Offset>::PersistentMultiSet()
+    : fd_(-1), base_(NULL), mappedBytes_(0), readOnly_(false)
+{}
+
+template <typename Data, typename Offset>
+PersistentMultiSet<Data, Offset>::PersistentMultiSet(const std::string& path, bool readOnly)
+    : fd_(-1), base_(NULL), mappedBytes_(0), readOnly_(false)
+{
+    open(path, readOnly);
+}
+
+template <typename Data, typename Offset>
+PersistentMultiSet<Data, Offset>::~PersistentMultiSet()
+{
+    close();
+}
+
+/// Maps an existing set file, or creates an empty one when the file is
+/// missing or empty and readOnly is false. Returns false if the file cannot
+/// be mapped or was written with a different Data size or Offset width.
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::open(const std::string& path, bool readOnly)
+{
+    close();
+    readOnly_ = readOnly;
+    fd_ = ::open(path.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) { return false; }
+    struct stat info;
+    if (0 != ::fstat(fd_, &info)) { close(); return false; }
+    if (0 == info.st_size && !readOnly) {
+        const std::size_t bytes = fileSize(PERSISTENT_MULTI_SET_INITIAL_CAPACITY);
+        if (0 != ::ftruncate(fd_, bytes) || !map(bytes)) { close(); return false; }
+        initHeader(PERSISTENT_MULTI_SET_INITIAL_CAPACITY);
+        return true;
+    }
+    if (static_cast<std::size_t>(info.st_size) < PERSISTENT_MULTI_SET_HEADER_BYTES
+        || !map(info.st_size) || !checkHeader()) { close(); return false; }
+    return true;
+}
+
+template <typename Data, typename Offset>
+void
+PersistentMultiSet<Data, Offset>::close()
+{
+    if (base_ != NULL) {
+        sync();
+        ::munmap(base_, mappedBytes_);
+    }
+    if (fd_ >= 0) { ::close(fd_); }
+    fd_ = -1;
+    base_ = NULL;
+    mappedBytes_ = 0;
+}
+
+/// Blocks until all changes made so far are written to the file.
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::sync()
+{
+    if (NULL == base_) { return false; }
+    if (readOnly_) { return true; }
+    return 0 == ::msync(base_, mappedBytes_, MS_SYNC);
+}
+
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::is_open() const
+{
+    return base_ != NULL;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::size_type
+PersistentMultiSet<Data, Offset>::size() const
+{
+    return NULL == base_ ? 0 : header()->size_;
+}
+
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::empty() const
+{
+    return 0 == size();
+}
+
+/// Drops all elements. The file keeps its size and the slots are reused.
+template <typename Data, typename Offset>
+void
+PersistentMultiSet<Data, Offset>::clear()
+{
+    assert(is_open() && !readOnly_);
+    Header* h = header();
+    h->used_ = 1;
+    h->size_ = 0;
+    h->root_ = 0;
+    h->freeList_ = 0;
+}
+
+template <typename Data, typename Offset>
+int
+PersistentMultiSet<Data, Offset>::height() const
+{
+    return empty() ? 0 : Algorithms::height(traits(), header()->root_);
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::begin() const
+{
+    return empty() ? end() : const_iterator(this, Algorithms::leftMost(traits(), header()->root_));
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::end() const
+{
+    return const_iterator(this, 0);
+}
+
+/// Equal elements keep their insertion order. The file grows by doubling
+/// when it runs out of slots; end() is returned if it cannot grow.
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::insert(const value_type& x)
+{
+    assert(is_open() && !readOnly_);
+    const Offset n = allocateNode(x);
+    if (0 == n) { return end(); }
+    const NodeTraits t = traits();
+    Offset parent = 0;
+    bool isLeft = false;
+    for (Offset current = header()->root_; current != 0;) {
+        parent = current;
+        isLeft = x < t.nodes_[current].data_;
+        current = isLeft ? t.left(current) : t.right(current);
+    }
+    Offset root = header()->root_;
+    Algorithms::insert(t, root, parent, isLeft, n);
+    header()->root_ = root;
+    ++header()->size_;
+    return const_iterator(this, n);
+}
+
+template <typename Data, typename Offset>
+void
+PersistentMultiSet<Data, Offset>::erase(const_iterator pos)
+{
+    assert(is_open() && !readOnly_);
+    assert(pos != end());
+    Offset root = header()->root_;
+    Algorithms::erase(traits(), root, pos.offset_);
+    header()->root_ = root;
+    --header()->size_;
+    freeNode(pos.offset_);
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::size_type
+PersistentMultiSet<Data, Offset>::erase(const key_type& k)
+{
+    size_type counter = 0;
+    const_iterator it = lower_bound(k);
+    while (it != end() && !(k < *it)) {
+        const_iterator temp = it++;
+        erase(temp);
+        ++counter;
+    }
+    return counter;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::find(const key_type& k) const
+{
+    const const_iterator it = lower_bound(k);
+    return (it == end() || k < *it) ? end() : it;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::size_type
+PersistentMultiSet<Data, Offset>::count(const key_type& k) const
+{
+    size_type counter = 0;
+    for (const_iterator it = lower_bound(k); it != end() && !(k < *it); ++it) { ++counter; }
+    return counter;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::lower_bound(const key_type& k) const
+{
+    if (empty()) { return end(); }
+    const Node* n = nodes();
+    Offset result = 0;
+    for (Offset current = header()->root_; current != 0;) {
+        if (n[current].data_ < k) {
+            current = n[current].right_;
+        } else {
+            result = current;
+            current = n[current].left_;
+        }
+    }
+    return const_iterator(this, result);
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::upper_bound(const key_type& k) const
+{
+    if (empty()) { return end(); }
+    const Node* n = nodes();
+    Offset result = 0;
+    for (Offset current = header()->root_; current != 0;) {
+        if (k < n[current].data_) {
+            result = current;
+            current = n[current].left_;
+        } else {
+            current = n[current].right_;
+        }
+    }
+    return const_iterator(this, result);
+}
+
+template <typename Data, typename Offset>
+std::pair<typename PersistentMultiSet<Data, Offset>::const_iterator,
+          typename PersistentMultiSet<Data, Offset>::const_iterator>
+PersistentMultiSet<Data, Offset>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::Header*
+PersistentMultiSet<Data, Offset>::header() const
+{
+    return reinterpret_cast<Header*>(base_);
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::Node*
+PersistentMultiSet<Data, Offset>::nodes() const
+{
+    return reinterpret_cast<Node*>(base_ + PERSISTENT_MULTI_SET_HEADER_BYTES);
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::NodeTraits
+PersistentMultiSet<Data, Offset>::traits() const
+{
+    return NodeTraits(nodes());
+}
+
+template <typename Data, typename Offset>
+std::size_t
+PersistentMultiSet<Data, Offset>::fileSize(uint64_t capacity)
+{
+    return PERSISTENT_MULTI_SET_HEADER_BYTES + capacity * sizeof(Node);
+}
+
+/// The old mapping is only released once the new one exists, so a failure
+/// leaves the set as it was.
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::map(std::size_t bytes)
+{
+    const int protection = readOnly_ ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* address = ::mmap(NULL, bytes, protection, MAP_SHARED, fd_, 0);
+    if (MAP_FAILED == address) { return false; }
+    if (base_ != NULL) { ::munmap(base_, mappedBytes_); }
+    base_ = static_cast<char*>(address);
+    mappedBytes_ = bytes;
+    return true;
+}
+
+/// Grows the file to hold capacity slots and maps it again. Offsets stay
+/// valid, raw pointers into the old mapping do not.
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::reserve(uint64_t capacity)
+{
+    if (capacity <= header()->capacity_) { return true; }
+    const std::size_t bytes = fileSize(capacity);
+    if (0 != ::ftruncate(fd_, bytes)) { return false; }
+    if (!map(bytes)) {
+        /// Best effort: the old size still holds every slot in use.
+        if (0 != ::ftruncate(fd_, mappedBytes_)) {}
+        return false;
+    }
+    header()->capacity_ = capacity;
+    return true;
+}
+
+template <typename Data, typename Offset>
+Offset
+PersistentMultiSet<Data, Offset>::allocateNode(const value_type& x)
+{
+    Offset n = static_cast<Offset>(header()->freeList_);
+    if (n != 0) {
+        header()->freeList_ = nodes()[n].left_;
+    } else {
+        const uint64_t used = header()->used_;
+        if (used > std::numeric_limits<Offset>::max()) { return 0; }
+        if (used >= header()->capacity_ && !reserve(header()->capacity_ * 2)) { return 0; }
+        n = static_cast<Offset>(used);
+        header()->used_ = used + 1;
+    }
+    nodes()[n].data_ = x;
+    return n;
+}
+
+template <typename Data, typename Offset>
+void
+PersistentMultiSet<Data, Offset>::freeNode(Offset n)
+{
+    nodes()[n].left_ = static_cast<Offset>(header()->freeList_);
+    header()->freeList_ = n;
+}
+
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::checkHeader() const
+{
+    const Header* h = header();
+    return 0 == std::memcmp(h->magic_, PERSISTENT_MULTI_SET_MAGIC, sizeof(h->magic_))
+        && PERSISTENT_MULTI_SET_VERSION == h->version_
+        && sizeof(Node) == h->nodeSize_
+        && sizeof(Offset) == h->offsetSize_
+        && h->used_ >= 1 && h->used_ <= h->capacity_
+        && fileSize(h->capacity_) <= mappedBytes_
+        && h->root_ < h->used_
+        && h->freeList_ < h->used_;
+}
+
+template <typename Data, typename Offset>
+void
+PersistentMultiSet<Data, Offset>::initHeader(uint64_t capacity)
+{
+    Header* h = header();
+    std::memcpy(h->magic_, PERSISTENT_MULTI_SET_MAGIC, sizeof(h->magic_));
+    h->version_ = PERSISTENT_MULTI_SET_VERSION;
+    h->nodeSize_ = sizeof(Node);
+    h->offsetSize_ = sizeof(Offset);
+    h->reserved_ = 0;
+    h->capacity_ = capacity;
+    h->used_ = 1;
+    h->size_ = 0;
+    h->root_ = 0;
+    h->freeList_ = 0;
+}
+
+/// const_iterator
+
+template <typename Data, typename Offset>
+PersistentMultiSet<Data, Offset>::const_iterator::const_iterator()
+    : set_(NULL), offset_(0)
+{}
+
+template <typename Data, typename Offset>
+PersistentMultiSet<Data, Offset>::const_iterator::const_iterator(const PersistentMultiSet* set, Offset offset)
+    : set_(set), offset_(offset)
+{}
+
+template <typename Data, typename Offset>
+const typename PersistentMultiSet<Data, Offset>::value_type&
+PersistentMultiSet<Data, Offset>::const_iterator::operator*() const
+{
+    return set_->nodes()[offset_].data_;
+}
+
+template <typename Data, typename Offset>
+const typename PersistentMultiSet<Data, Offset>::value_type*
+PersistentMultiSet<Data, Offset>::const_iterator::operator->() const
+{
+    return &set_->nodes()[offset_].data_;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator&
+PersistentMultiSet<Data, Offset>::const_iterator::operator++()
+{
+    offset_ = Algorithms::next(set_->traits(), offset_);
+    return *this;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::const_iterator::operator++(int)
+{
+    const const_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+/// Decrementing end() moves to the largest element.
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator&
+PersistentMultiSet<Data, Offset>::const_iterator::operator--()
+{
+    const NodeTraits t = set_->traits();
+    offset_ = (0 == offset_) ? Algorithms::rightMost(t, set_->header()->root_)
+                             : Algorithms::prev(t, offset_);
+    return *this;
+}
+
+template <typename Data, typename Offset>
+typename PersistentMultiSet<Data, Offset>::const_iterator
+PersistentMultiSet<Data, Offset>::const_iterator::operator--(int)
+{
+    const const_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::const_iterator::operator==(const const_iterator& rhv) const
+{
+    return offset_ == rhv.offset_;
+}
+
+template <typename Data, typename Offset>
+bool
+PersistentMultiSet<Data, Offset>::const_iterator::operator!=(const const_iterator& rhv) const
+{
+    return !(*this == rhv);
+}
+
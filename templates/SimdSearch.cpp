@@ -0,0 +1,290 @@
+#include "headers/SimdSearch.hpp"
+#ifdef MULTISET_SIMD_X86
+#include <immintrin.h>
+#endif
+
+template <typename T>
+const typename SimdSearch<T>::Kernels&
+SimdSearch<T>::kernels()
+{
+    static const Kernels selected = select(std::integral_constant<bool, SimdKernels<T>::SUPPORTED != 0>());
+    return selected;
+}
+
+template <typename T>
+unsigned
+SimdSearch<T>::countLess(const T* block, T key)
+{
+    return kernels().less_(block, key);
+}
+
+template <typename T>
+unsigned
+SimdSearch<T>::countLessEqual(const T* block, T key)
+{
+    return kernels().lessEqual_(block, key);
+}
+
+template <typename T>
+const char*
+SimdSearch<T>::instructionSet()
+{
+    return kernels().name_;
+}
+
+template <typename T>
+typename SimdSearch<T>::Kernels
+SimdSearch<T>::select(std::true_type)
+{
+#ifdef MULTISET_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        const Kernels avx2 = { SimdKernels<T>::avx2Less, SimdKernels<T>::avx2LessEqual, "avx2" };
+        return avx2;
+    }
+    if (SimdKernels<T>::sseSupported()) {
+        const Kernels sse = { SimdKernels<T>::sseLess, SimdKernels<T>::sseLessEqual, "sse" };
+        return sse;
+    }
+#endif
+    return select(std::false_type());
+}
+
+template <typename T>
+typename SimdSearch<T>::Kernels
+SimdSearch<T>::select(std::false_type)
+{
+    const Kernels scalar = { scalarLess, scalarLessEqual, "scalar" };
+    return scalar;
+}
+
+template <typename T>
+unsigned
+SimdSearch<T>::scalarLess(const T* block, T key)
+{
+    unsigned result = 0;
+    for (int i = 0; i < BLOCK; ++i) { result += block[i] < key; }
+    return result;
+}
+
+template <typename T>
+unsigned
+SimdSearch<T>::scalarLessEqual(const T* block, T key)
+{
+    unsigned result = 0;
+    for (int i = 0; i < BLOCK; ++i) { result += !(key < block[i]); }
+    return result;
+}
+
+#ifdef MULTISET_SIMD_X86
+
+/// Every kernel compares a whole 64-byte block (two AVX2 or four SSE
+/// registers) and counts the set bits of the movemask.
+
+/// int32_t, 16 keys per block
+
+inline bool
+SimdKernels<int32_t>::sseSupported()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<int32_t>::avx2Less(const int32_t* block, int32_t key)
+{
+    const __m256i k = _mm256_set1_epi32(key);
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 8));
+    const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, a)))
+                   | _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, b))) << 8;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<int32_t>::avx2LessEqual(const int32_t* block, int32_t key)
+{
+    const __m256i k = _mm256_set1_epi32(key);
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 8));
+    const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, k)))
+                   | _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, k))) << 8;
+    return 16 - __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<int32_t>::sseLess(const int32_t* block, int32_t key)
+{
+    const __m128i k = _mm_set1_epi32(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * i));
+        mask |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, a))) << (4 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<int32_t>::sseLessEqual(const int32_t* block, int32_t key)
+{
+    const __m128i k = _mm_set1_epi32(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * i));
+        mask |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a, k))) << (4 * i);
+    }
+    return 16 - __builtin_popcount(mask);
+}
+
+/// int64_t, 8 keys per block
+
+inline bool
+SimdKernels<int64_t>::sseSupported()
+{
+    return __builtin_cpu_supports("sse4.2");
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<int64_t>::avx2Less(const int64_t* block, int64_t key)
+{
+    const __m256i k = _mm256_set1_epi64x(key);
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 4));
+    const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, a)))
+                   | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, b))) << 4;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<int64_t>::avx2LessEqual(const int64_t* block, int64_t key)
+{
+    const __m256i k = _mm256_set1_epi64x(key);
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 4));
+    const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, k)))
+                   | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(b, k))) << 4;
+    return 8 - __builtin_popcount(mask);
+}
+
+__attribute__((target("sse4.2"))) inline unsigned
+SimdKernels<int64_t>::sseLess(const int64_t* block, int64_t key)
+{
+    const __m128i k = _mm_set1_epi64x(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 2 * i));
+        mask |= _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, a))) << (2 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse4.2"))) inline unsigned
+SimdKernels<int64_t>::sseLessEqual(const int64_t* block, int64_t key)
+{
+    const __m128i k = _mm_set1_epi64x(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 2 * i));
+        mask |= _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(a, k))) << (2 * i);
+    }
+    return 8 - __builtin_popcount(mask);
+}
+
+/// float, 16 keys per block; the predicates match the scalar
+/// x < key and !(key < x), also for NaN.
+
+inline bool
+SimdKernels<float>::sseSupported()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<float>::avx2Less(const float* block, float key)
+{
+    const __m256 k = _mm256_set1_ps(key);
+    const int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(block), k, _CMP_LT_OQ))
+                   | _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(block + 8), k, _CMP_LT_OQ)) << 8;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<float>::avx2LessEqual(const float* block, float key)
+{
+    const __m256 k = _mm256_set1_ps(key);
+    const int mask = _mm256_movemask_ps(_mm256_cmp_ps(k, _mm256_loadu_ps(block), _CMP_NLT_UQ))
+                   | _mm256_movemask_ps(_mm256_cmp_ps(k, _mm256_loadu_ps(block + 8), _CMP_NLT_UQ)) << 8;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<float>::sseLess(const float* block, float key)
+{
+    const __m128 k = _mm_set1_ps(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(block + 4 * i), k)) << (4 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<float>::sseLessEqual(const float* block, float key)
+{
+    const __m128 k = _mm_set1_ps(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= _mm_movemask_ps(_mm_cmpnlt_ps(k, _mm_loadu_ps(block + 4 * i))) << (4 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+/// double, 8 keys per block
+
+inline bool
+SimdKernels<double>::sseSupported()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<double>::avx2Less(const double* block, double key)
+{
+    const __m256d k = _mm256_set1_pd(key);
+    const int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(block), k, _CMP_LT_OQ))
+                   | _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(block + 4), k, _CMP_LT_OQ)) << 4;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2"))) inline unsigned
+SimdKernels<double>::avx2LessEqual(const double* block, double key)
+{
+    const __m256d k = _mm256_set1_pd(key);
+    const int mask = _mm256_movemask_pd(_mm256_cmp_pd(k, _mm256_loadu_pd(block), _CMP_NLT_UQ))
+                   | _mm256_movemask_pd(_mm256_cmp_pd(k, _mm256_loadu_pd(block + 4), _CMP_NLT_UQ)) << 4;
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<double>::sseLess(const double* block, double key)
+{
+    const __m128d k = _mm_set1_pd(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= _mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(block + 2 * i), k)) << (2 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("sse2"))) inline unsigned
+SimdKernels<double>::sseLessEqual(const double* block, double key)
+{
+    const __m128d k = _mm_set1_pd(key);
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= _mm_movemask_pd(_mm_cmpnlt_pd(k, _mm_loadu_pd(block + 2 * i))) << (2 * i);
+    }
+    return __builtin_popcount(mask);
+}
+
+#endif /// MULTISET_SIMD_X86
+
@@ -0,0 +1,356 @@
+#include "headers/SmallMultiSet.hpp"
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+template <typename Data, std::size_t N>
+const typename SmallMultiSet<Data, N>::size_type SmallMultiSet<Data, N>::INLINE_CAPACITY;
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::SmallMultiSet()
+    : size_(0), tree_(NULL)
+{}
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::SmallMultiSet(const SmallMultiSet& rhv)
+    : size_(0), tree_(NULL)
+{
+    *this = rhv;
+}
+
+template <typename Data, std::size_t N>
+template <typename InputIterator>
+SmallMultiSet<Data, N>::SmallMultiSet(InputIterator first, InputIterator last)
+    : size_(0), tree_(NULL)
+{
+    for (; first != last; ++first) { insert(*first); }
+}
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::~SmallMultiSet()
+{
+    clear();
+}
+
+/// A copy is inline whenever the elements fit, whatever rhv is.
+template <typename Data, std::size_t N>
+const SmallMultiSet<Data, N>&
+SmallMultiSet<Data, N>::operator=(const SmallMultiSet& rhv)
+{
+    if (this == &rhv) { return *this; }
+    clear();
+    if (rhv.size_ > N) {
+        tree_ = new Tree(*rhv.tree_);
+        size_ = rhv.size_;
+        return *this;
+    }
+    value_type* const target = elements();
+    for (const_iterator it = rhv.begin(); it != rhv.end(); ++it) {
+        ::new (target + size_) value_type(*it);
+        ++size_;
+    }
+    return *this;
+}
+
+/// Two trees trade pointers; inline elements have to be copied.
+template <typename Data, std::size_t N>
+void
+SmallMultiSet<Data, N>::swap(SmallMultiSet& rhv)
+{
+    if (tree_ != NULL && rhv.tree_ != NULL) {
+        std::swap(tree_, rhv.tree_);
+        std::swap(size_, rhv.size_);
+        return;
+    }
+    const SmallMultiSet temp(rhv);
+    rhv = *this;
+    *this = temp;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::size_type
+SmallMultiSet<Data, N>::size() const
+{
+    return size_;
+}
+
+template <typename Data, std::size_t N>
+bool
+SmallMultiSet<Data, N>::empty() const
+{
+    return 0 == size_;
+}
+
+template <typename Data, std::size_t N>
+bool
+SmallMultiSet<Data, N>::is_inline() const
+{
+    return NULL == tree_;
+}
+
+template <typename Data, std::size_t N>
+void
+SmallMultiSet<Data, N>::clear()
+{
+    if (NULL == tree_) {
+        destroyInline();
+        return;
+    }
+    delete tree_;
+    tree_ = NULL;
+    size_ = 0;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::begin() const
+{
+    return NULL == tree_ ? const_iterator(this, 0) : const_iterator(this, tree_->begin());
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::end() const
+{
+    return NULL == tree_ ? const_iterator(this, size_) : const_iterator(this, tree_->end());
+}
+
+/// Equal elements keep their insertion order. Inserting the (N + 1)-th
+/// element moves the others into a tree first.
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::insert(const value_type& x)
+{
+    if (NULL == tree_ && N == size_) {
+        /// x may be one of the inline elements, which moveToTree destroys.
+        const value_type copy(x);
+        moveToTree();
+        return insert(copy);
+    }
+    if (tree_ != NULL) {
+        const typename Tree::iterator it = tree_->insert(x);
+        ++size_;
+        return const_iterator(this, it);
+    }
+    value_type* const first = elements();
+    value_type* const last = first + size_;
+    value_type* const pos = std::upper_bound(first, last, x);
+    if (pos == last) {
+        ::new (last) value_type(x);
+    } else {
+        value_type copy(x);
+        ::new (last) value_type(std::move(*(last - 1)));
+        std::move_backward(pos, last - 1, last);
+        *pos = std::move(copy);
+    }
+    ++size_;
+    return const_iterator(this, pos - first);
+}
+
+template <typename Data, std::size_t N>
+void
+SmallMultiSet<Data, N>::erase(const_iterator pos)
+{
+    assert(pos != end());
+    --size_;
+    if (tree_ != NULL) {
+        tree_->erase(pos.node_);
+        return;
+    }
+    value_type* const first = elements();
+    std::move(first + pos.index_ + 1, first + size_ + 1, first + pos.index_);
+    first[size_].~value_type();
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::size_type
+SmallMultiSet<Data, N>::erase(const key_type& k)
+{
+    if (tree_ != NULL) {
+        const size_type counter = tree_->erase(k);
+        size_ -= counter;
+        return counter;
+    }
+    value_type* const first = elements();
+    value_type* const last = first + size_;
+    const std::pair<value_type*, value_type*> range = std::equal_range(first, last, k);
+    const size_type counter = range.second - range.first;
+    if (0 == counter) { return 0; }
+    value_type* const newLast = std::move(range.second, last, range.first);
+    for (value_type* p = newLast; p != last; ++p) { p->~value_type(); }
+    size_ -= counter;
+    return counter;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::find(const key_type& k) const
+{
+    const const_iterator it = lower_bound(k);
+    return (it == end() || k < *it) ? end() : it;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::size_type
+SmallMultiSet<Data, N>::count(const key_type& k) const
+{
+    if (tree_ != NULL) { return tree_->count(k); }
+    const std::pair<const value_type*, const value_type*> range
+        = std::equal_range(elements(), elements() + size_, k);
+    return range.second - range.first;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::lower_bound(const key_type& k) const
+{
+    if (tree_ != NULL) { return const_iterator(this, tree_->lower_bound(k)); }
+    return const_iterator(this, std::lower_bound(elements(), elements() + size_, k) - elements());
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::upper_bound(const key_type& k) const
+{
+    if (tree_ != NULL) { return const_iterator(this, tree_->upper_bound(k)); }
+    return const_iterator(this, std::upper_bound(elements(), elements() + size_, k) - elements());
+}
+
+template <typename Data, std::size_t N>
+std::pair<typename SmallMultiSet<Data, N>::const_iterator, typename SmallMultiSet<Data, N>::const_iterator>
+SmallMultiSet<Data, N>::equal_range(const key_type& k) const
+{
+    return std::make_pair(lower_bound(k), upper_bound(k));
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::value_type*
+SmallMultiSet<Data, N>::elements()
+{
+    return reinterpret_cast<value_type*>(&buffer_);
+}
+
+template <typename Data, std::size_t N>
+const typename SmallMultiSet<Data, N>::value_type*
+SmallMultiSet<Data, N>::elements() const
+{
+    return reinterpret_cast<const value_type*>(&buffer_);
+}
+
+/// Happens once, when the set outgrows the inline array.
+template <typename Data, std::size_t N>
+void
+SmallMultiSet<Data, N>::moveToTree()
+{
+    Tree* tree = new Tree(elements(), elements() + size_);
+    const size_type count = size_;
+    destroyInline();
+    tree_ = tree;
+    size_ = count;
+}
+
+template <typename Data, std::size_t N>
+void
+SmallMultiSet<Data, N>::destroyInline()
+{
+    value_type* const first = elements();
+    for (size_type i = 0; i < size_; ++i) { first[i].~value_type(); }
+    size_ = 0;
+}
+
+/// const_iterator
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::const_iterator::const_iterator()
+    : set_(NULL), index_(0), node_()
+{}
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::const_iterator::const_iterator(const SmallMultiSet* set, size_type index)
+    : set_(set), index_(index), node_()
+{}
+
+template <typename Data, std::size_t N>
+SmallMultiSet<Data, N>::const_iterator::const_iterator(const SmallMultiSet* set, typename Tree::iterator node)
+    : set_(set), index_(0), node_(node)
+{}
+
+template <typename Data, std::size_t N>
+const typename SmallMultiSet<Data, N>::value_type&
+SmallMultiSet<Data, N>::const_iterator::operator*() const
+{
+    if (NULL == set_->tree_) { return set_->elements()[index_]; }
+    const typename Tree::const_iterator& node = node_;
+    return *node;
+}
+
+template <typename Data, std::size_t N>
+const typename SmallMultiSet<Data, N>::value_type*
+SmallMultiSet<Data, N>::const_iterator::operator->() const
+{
+    return &**this;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator&
+SmallMultiSet<Data, N>::const_iterator::operator++()
+{
+    if (NULL == set_->tree_) {
+        ++index_;
+    } else {
+        ++node_;
+    }
+    return *this;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::const_iterator::operator++(int)
+{
+    const const_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+/// Decrementing end() moves to the largest element. The tree's end() has
+/// no predecessor link, so the last element is found from its key.
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator&
+SmallMultiSet<Data, N>::const_iterator::operator--()
+{
+    if (NULL == set_->tree_) {
+        --index_;
+        return *this;
+    }
+    if (node_ != set_->tree_->end()) {
+        --node_;
+        return *this;
+    }
+    node_ = set_->tree_->lower_bound(*set_->tree_->rbegin());
+    for (typename Tree::iterator next = node_; ++next != set_->tree_->end();) { node_ = next; }
+    return *this;
+}
+
+template <typename Data, std::size_t N>
+typename SmallMultiSet<Data, N>::const_iterator
+SmallMultiSet<Data, N>::const_iterator::operator--(int)
+{
+    const const_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+template <typename Data, std::size_t N>
+bool
+SmallMultiSet<Data, N>::const_iterator::operator==(const const_iterator& rhv) const
+{
+    return index_ == rhv.index_ && node_ == rhv.node_;
+}
+
+template <typename Data, std::size_t N>
+bool
+SmallMultiSet<Data, N>::const_iterator::operator!=(const const_iterator& rhv) const
+{
+    return !(*this == rhv);
+}
+
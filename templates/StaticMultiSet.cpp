@@ -0,0 +1,206 @@
+#include "headers/StaticMultiSet.hpp"
+#include <algorithm>
+#include <cassert>
+
+template <typename Data, std::size_t N>
+const typename StaticMultiSet<Data, N>::size_type StaticMultiSet<Data, N>::CAPACITY;
+
+template <typename Data, std::size_t N>
+constexpr StaticMultiSet<Data, N>::StaticMultiSet()
+    : data_(), size_(0)
+{}
+
+template <typename Data, std::size_t N>
+template <typename... Args>
+constexpr StaticMultiSet<Data, N>::StaticMultiSet(const Data& first, const Args&... rest)
+    : StaticMultiSet(typename MakeIndices<1 + sizeof...(Args)>::type(),
+                     Values<1 + sizeof...(Args)>{ { first, rest... } })
+{
+    static_assert(1 + sizeof...(Args) <= N, "more elements than the capacity");
+}
+
+/// Slot i gets the argument of rank i; the slots past the arguments are
+/// value-initialized.
+template <typename Data, std::size_t N>
+template <std::size_t K, std::size_t... Is>
+constexpr StaticMultiSet<Data, N>::StaticMultiSet(Indices<Is...>, const Values<K>& values)
+    : data_{ nth(values, Is, 0)... }, size_(K)
+{}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::size() const
+{
+    return size_;
+}
+
+template <typename Data, std::size_t N>
+constexpr bool
+StaticMultiSet<Data, N>::empty() const
+{
+    return 0 == size_;
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::max_size() const
+{
+    return N;
+}
+
+/// The slots keep their old values until they are overwritten.
+template <typename Data, std::size_t N>
+void
+StaticMultiSet<Data, N>::clear()
+{
+    size_ = 0;
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::begin() const
+{
+    return data_;
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::end() const
+{
+    return data_ + size_;
+}
+
+/// Equal elements keep their insertion order. Returns end() when the set
+/// is full.
+template <typename Data, std::size_t N>
+typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::insert(const value_type& x)
+{
+    if (N == size_) { return end(); }
+    const size_type index = upperIndex(x, 0, size_);
+    std::copy_backward(data_ + index, data_ + size_, data_ + size_ + 1);
+    data_[index] = x;
+    ++size_;
+    return data_ + index;
+}
+
+template <typename Data, std::size_t N>
+void
+StaticMultiSet<Data, N>::erase(const_iterator pos)
+{
+    assert(pos != end());
+    const size_type index = pos - data_;
+    std::copy(data_ + index + 1, data_ + size_, data_ + index);
+    --size_;
+}
+
+template <typename Data, std::size_t N>
+typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::erase(const key_type& k)
+{
+    const size_type first = lowerIndex(k, 0, size_);
+    const size_type last = upperIndex(k, 0, size_);
+    std::copy(data_ + last, data_ + size_, data_ + first);
+    size_ -= last - first;
+    return last - first;
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::find(const key_type& k) const
+{
+    return findHelper(k, lowerIndex(k, 0, size_));
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::count(const key_type& k) const
+{
+    return upperIndex(k, 0, size_) - lowerIndex(k, 0, size_);
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::lower_bound(const key_type& k) const
+{
+    return data_ + lowerIndex(k, 0, size_);
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::upper_bound(const key_type& k) const
+{
+    return data_ + upperIndex(k, 0, size_);
+}
+
+template <typename Data, std::size_t N>
+constexpr std::pair<typename StaticMultiSet<Data, N>::const_iterator, typename StaticMultiSet<Data, N>::const_iterator>
+StaticMultiSet<Data, N>::equal_range(const key_type& k) const
+{
+    return std::pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+}
+
+/// Binary search over the count slots from first, written as recursion so
+/// that it can run at compile time.
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::lowerIndex(const key_type& k, size_type first, size_type count) const
+{
+    return 0 == count ? first
+         : data_[first + count / 2] < k ? lowerIndex(k, first + count / 2 + 1, count - count / 2 - 1)
+         : lowerIndex(k, first, count / 2);
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::upperIndex(const key_type& k, size_type first, size_type count) const
+{
+    return 0 == count ? first
+         : !(k < data_[first + count / 2]) ? upperIndex(k, first + count / 2 + 1, count - count / 2 - 1)
+         : upperIndex(k, first, count / 2);
+}
+
+template <typename Data, std::size_t N>
+constexpr typename StaticMultiSet<Data, N>::const_iterator
+StaticMultiSet<Data, N>::findHelper(const key_type& k, size_type index) const
+{
+    return (index == size_ || k < data_[index]) ? end() : data_ + index;
+}
+
+/// Sorting at compile time: the argument at j belongs to slot rank(j),
+/// the number of arguments less than it plus the equal ones before it.
+/// Quadratic per slot, which is fine for tables written out in source.
+template <typename Data, std::size_t N>
+template <std::size_t K>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::countLess(const Values<K>& v, const Data& x, size_type i)
+{
+    return K == i ? 0 : (v.values_[i] < x ? 1 : 0) + countLess(v, x, i + 1);
+}
+
+template <typename Data, std::size_t N>
+template <std::size_t K>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::countEqualBefore(const Values<K>& v, size_type j, size_type i)
+{
+    return j == i ? 0
+         : (!(v.values_[i] < v.values_[j]) && !(v.values_[j] < v.values_[i]) ? 1 : 0)
+           + countEqualBefore(v, j, i + 1);
+}
+
+template <typename Data, std::size_t N>
+template <std::size_t K>
+constexpr typename StaticMultiSet<Data, N>::size_type
+StaticMultiSet<Data, N>::rank(const Values<K>& v, size_type j)
+{
+    return countLess(v, v.values_[j], 0) + countEqualBefore(v, j, 0);
+}
+
+template <typename Data, std::size_t N>
+template <std::size_t K>
+constexpr Data
+StaticMultiSet<Data, N>::nth(const Values<K>& v, size_type n, size_type j)
+{
+    return rank(v, j) == n ? v.values_[j] : nth(v, n, j + 1);
+}
+